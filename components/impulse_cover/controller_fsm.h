@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome {
+namespace impulse_cover {
+
+// How the gate controller reacts to a press of its single impulse input
+enum ControllerProfile : uint8_t {
+  CONTROLLER_OPEN_STOP_CLOSE_STOP = 0,  // a press stops a moving gate, the next one reverses
+  CONTROLLER_OPEN_STOP_CLOSE,           // a press stops an opening gate and reverses a closing one
+  CONTROLLER_OPEN_CLOSE_OPEN,           // a press reverses a moving gate; it only stops at the ends
+  CONTROLLER_PROFILE_COUNT,
+};
+
+// The controller's hidden state, tracked from the presses sent to it
+enum ControllerState : uint8_t {
+  CONTROLLER_STOPPED_NEXT_OPEN = 0,
+  CONTROLLER_STOPPED_NEXT_CLOSE,
+  CONTROLLER_OPENING,
+  CONTROLLER_CLOSING,
+  CONTROLLER_STATE_COUNT,
+};
+
+// What the cover wants the controller to do
+enum ControllerGoal : uint8_t {
+  CONTROLLER_GOAL_STOP = 0,
+  CONTROLLER_GOAL_OPEN,
+  CONTROLLER_GOAL_CLOSE,
+};
+
+// State after one press, per profile
+static const ControllerState CONTROLLER_PRESS[CONTROLLER_PROFILE_COUNT][CONTROLLER_STATE_COUNT] = {
+    // open -> stop -> close -> stop
+    {CONTROLLER_OPENING, CONTROLLER_CLOSING, CONTROLLER_STOPPED_NEXT_CLOSE, CONTROLLER_STOPPED_NEXT_OPEN},
+    // open -> stop -> close -> open
+    {CONTROLLER_OPENING, CONTROLLER_CLOSING, CONTROLLER_STOPPED_NEXT_CLOSE, CONTROLLER_OPENING},
+    // open -> close -> open
+    {CONTROLLER_OPENING, CONTROLLER_CLOSING, CONTROLLER_CLOSING, CONTROLLER_OPENING},
+};
+
+// Tracks the controller state through the transition table of its profile
+// and finds the number of presses that takes it to a goal
+class ControllerFsm {
+ public:
+  // Longest press chain to any reachable state: the cycle has four states
+  static const uint8_t MAX_PRESSES = CONTROLLER_STATE_COUNT - 1;
+  static const uint8_t UNREACHABLE = 0xFF;
+
+  void set_profile(ControllerProfile profile) { this->profile_ = profile; }
+  ControllerProfile get_profile() const { return this->profile_; }
+  ControllerState get_state() const { return this->state_; }
+  void set_state(ControllerState state) { this->state_ = state; }
+
+  // One press reached the controller
+  void press() { this->state_ = this->after(this->state_, 1); }
+  // State reached from state by that many presses
+  ControllerState after(ControllerState state, uint8_t presses) const {
+    for (uint8_t i = 0; i < presses; i++)
+      state = CONTROLLER_PRESS[this->profile_][state];
+    return state;
+  }
+  // A press of a dedicated open, close or stop input: the controller goes straight to goal
+  void command(ControllerGoal goal) {
+    if (goal == CONTROLLER_GOAL_OPEN) {
+      this->state_ = CONTROLLER_OPENING;
+    } else if (goal == CONTROLLER_GOAL_CLOSE) {
+      this->state_ = CONTROLLER_CLOSING;
+    } else if (this->state_ == CONTROLLER_OPENING || this->state_ == CONTROLLER_CLOSING) {
+      this->state_ = this->state_ == CONTROLLER_OPENING ? CONTROLLER_STOPPED_NEXT_CLOSE : CONTROLLER_STOPPED_NEXT_OPEN;
+    }
+  }
+  // The controller reached an end by itself, or the cover was driven there: at
+  // rest, the next press moves away from it
+  void at_end(bool open_end) { this->state_ = end_state(open_end); }
+  // Fewest presses from state to goal, or UNREACHABLE
+  uint8_t presses_to(ControllerState state, ControllerGoal goal) const {
+    for (uint8_t presses = 0; presses <= MAX_PRESSES; presses++) {
+      if (reaches(state, goal))
+        return presses;
+      state = CONTROLLER_PRESS[this->profile_][state];
+    }
+    return UNREACHABLE;
+  }
+  // Presses out of presses from state that set the gate moving or reverse it
+  uint8_t starts(ControllerState state, uint8_t presses) const {
+    uint8_t starts = 0;
+    for (uint8_t i = 0; i < presses; i++) {
+      const ControllerState next = CONTROLLER_PRESS[this->profile_][state];
+      starts += next != state && !reaches(next, CONTROLLER_GOAL_STOP);
+      state = next;
+    }
+    return starts;
+  }
+  // Whether a press can bring a moving gate to rest between the ends
+  bool can_stop() const {
+    return this->presses_to(CONTROLLER_OPENING, CONTROLLER_GOAL_STOP) != UNREACHABLE &&
+           this->presses_to(CONTROLLER_CLOSING, CONTROLLER_GOAL_STOP) != UNREACHABLE;
+  }
+
+  // At rest at an end, the next press moves away from it
+  static ControllerState end_state(bool open_end) {
+    return open_end ? CONTROLLER_STOPPED_NEXT_CLOSE : CONTROLLER_STOPPED_NEXT_OPEN;
+  }
+  static bool reaches(ControllerState state, ControllerGoal goal) {
+    switch (goal) {
+      case CONTROLLER_GOAL_OPEN:
+        return state == CONTROLLER_OPENING;
+      case CONTROLLER_GOAL_CLOSE:
+        return state == CONTROLLER_CLOSING;
+      default:
+        return state == CONTROLLER_STOPPED_NEXT_OPEN || state == CONTROLLER_STOPPED_NEXT_CLOSE;
+    }
+  }
+
+ protected:
+  ControllerProfile profile_{CONTROLLER_OPEN_STOP_CLOSE_STOP};
+  ControllerState state_{CONTROLLER_STOPPED_NEXT_OPEN};
+};
+
+}  // namespace impulse_cover
+}  // namespace esphome
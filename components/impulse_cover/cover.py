@@ -1,14 +1,20 @@
-from esphome import automation
+from esphome import automation, pins
 import esphome.codegen as cg
-from esphome.components import binary_sensor, cover, output
+from esphome.components import binary_sensor, cover, output, sensor
 import esphome.config_validation as cv
 from esphome.const import (
     CONF_CLOSE_DURATION,
     CONF_ID,
     CONF_OPEN_DURATION,
     CONF_OUTPUT,
+    CONF_PLATFORM,
+    CONF_POSITION,
+    CONF_SENSOR,
+    CONF_TIME,
     CONF_TRIGGER_ID,
 )
+from esphome.core import CORE
+import esphome.final_validate as fv
 
 DEPENDENCIES = ["cover"]
 
@@ -20,47 +26,397 @@ CONF_OPEN_SENSOR = "open_sensor"
 CONF_CLOSE_SENSOR = "close_sensor"
 CONF_OPEN_SENSOR_INVERTED = "open_sensor_inverted"
 CONF_CLOSE_SENSOR_INVERTED = "close_sensor_inverted"
+CONF_OPEN_SENSOR_PIN = "open_sensor_pin"
+CONF_CLOSE_SENSOR_PIN = "close_sensor_pin"
+CONF_ENDSTOP_DEBOUNCE = "endstop_debounce"
+CONF_MOTION_MODE = "motion_mode"
+CONF_OPEN_CURVE = "open_curve"
+CONF_CLOSE_CURVE = "close_curve"
+CONF_POINTS = "points"
+CONF_ACCEL_TIME = "accel_time"
+CONF_DECEL_TIME = "decel_time"
+CONF_OPEN_STOP_LEAD = "open_stop_lead"
+CONF_CLOSE_STOP_LEAD = "close_stop_lead"
+CONF_LEARN_STOP_LEAD = "learn_stop_lead"
+CONF_LEARN_DURATIONS = "learn_durations"
+CONF_MIN_SAVE_INTERVAL = "min_save_interval"
+CONF_PUBLISH_POLICY = "publish_policy"
+CONF_MIN_DELTA = "min_delta"
+CONF_MIN_INTERVAL = "min_interval"
+CONF_TRANSITIONS_ONLY = "transitions_only"
+CONF_HEARTBEAT = "heartbeat"
+CONF_TRACE_SIZE = "trace_size"
+CONF_COMMAND_SETTLE = "command_settle"
+CONF_HUB_ID = "hub_id"
+CONF_FIXED_POINT = "fixed_point"
+CONF_ZERO_HEAP = "zero_heap"
+CONF_PULSE_PATTERNS = "pulse_patterns"
+CONF_PRESS = "press"
+CONF_PAUSE = "pause"
+CONF_CONTROLLER_PROFILE = "controller_profile"
+CONF_OPEN_OUTPUT = "open_output"
+CONF_CLOSE_OUTPUT = "close_output"
+CONF_STOP_OUTPUT = "stop_output"
+CONF_POSITION_SENSORS = "position_sensors"
+CONF_ENCODER_SENSOR = "encoder_sensor"
+CONF_ENCODER_COUNTS_PER_TRAVEL = "encoder_counts_per_travel"
+CONF_CURRENT_SENSOR = "current_sensor"
+CONF_CURRENT_THRESHOLD = "current_threshold"
+CONF_CURRENT_START_TIME = "current_start_time"
+CONF_CURRENT_STOP_TIME = "current_stop_time"
+CONF_STALL_THRESHOLD = "stall_threshold"
+CONF_STALL_TIME = "stall_time"
+CONF_ACK_TIMEOUT = "ack_timeout"
+CONF_ACK_RETRIES = "ack_retries"
 # Only unique triggers that don't exist in base ESPHome cover
 CONF_ON_SAFETY = "on_safety"  # Specific to impulse cover safety logic
 
 # Component namespace and class
 impulse_cover_ns = cg.esphome_ns.namespace("impulse_cover")
 ImpulseCover = impulse_cover_ns.class_("ImpulseCover", cover.Cover, cg.Component)
+TravelCurve = impulse_cover_ns.class_("TravelCurve")
+# Instantiated per configuration with the endstop sensors and their inversions
+TopologyCover = impulse_cover_ns.class_("TopologyCover", ImpulseCover)
+SensorTopology = impulse_cover_ns.struct("SensorTopology")
+
+# Declared by the impulse_cover_hub component
+ImpulseCoverHub = cg.esphome_ns.namespace("impulse_cover_hub").class_("ImpulseCoverHub", cg.Component)
+
+MotionMode = impulse_cover_ns.enum("MotionMode")
+MOTION_MODES = {
+    "polling": MotionMode.MOTION_MODE_POLLING,
+    "event": MotionMode.MOTION_MODE_EVENT,
+}
+
+PulsePattern = impulse_cover_ns.enum("PulsePattern")
+PULSE_PATTERNS = {
+    "single": PulsePattern.PULSE_SINGLE,
+    "double": PulsePattern.PULSE_DOUBLE,
+    "stop": PulsePattern.PULSE_STOP,
+}
+# Presses the controller counts per pattern
+PULSE_PATTERN_PRESSES = {"single": 1, "double": 2, "stop": 1}
+
+ControllerProfile = impulse_cover_ns.enum("ControllerProfile")
+CONTROLLER_PROFILES = {
+    "open_stop_close_stop": ControllerProfile.CONTROLLER_OPEN_STOP_CLOSE_STOP,
+    "open_stop_close": ControllerProfile.CONTROLLER_OPEN_STOP_CLOSE,
+    "open_close_open": ControllerProfile.CONTROLLER_OPEN_CLOSE_OPEN,
+}
+
+PULSE_STEP_DURATION = cv.All(
+    cv.positive_time_period_milliseconds,
+    cv.Range(min=cv.TimePeriod(milliseconds=1), max=cv.TimePeriod(milliseconds=32767)),
+)
+PULSE_STEP_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.Optional(CONF_PRESS): PULSE_STEP_DURATION,
+            cv.Optional(CONF_PAUSE): PULSE_STEP_DURATION,
+        }
+    ),
+    cv.has_exactly_one_key(CONF_PRESS, CONF_PAUSE),
+)
+
+
+def validate_pulse_pattern(value):
+    value = cv.ensure_list(PULSE_STEP_SCHEMA)(value)
+    if not 1 <= len(value) <= 8:
+        raise cv.Invalid("A pulse pattern has 1 to 8 steps")
+    if CONF_PRESS not in value[0]:
+        raise cv.Invalid("A pulse pattern starts with a press")
+    for prev, step in zip(value, value[1:]):
+        if (CONF_PRESS in prev) == (CONF_PRESS in step):
+            raise cv.Invalid("Presses and pauses of a pulse pattern alternate")
+    return value
+
+
+def validate_pattern_presses(value):
+    # The controller state is tracked per press, so each pattern keeps its press count
+    for name, steps in value.items():
+        presses = sum(1 for step in steps if CONF_PRESS in step)
+        if presses != PULSE_PATTERN_PRESSES[name]:
+            raise cv.Invalid(
+                f"The {name} pattern has {PULSE_PATTERN_PRESSES[name]} press(es), not {presses}",
+                [name],
+            )
+    return value
+
+
+# Relay steps per pattern; patterns left out are built from pulse_delay
+PULSE_PATTERNS_SCHEMA = cv.All(
+    cv.Schema({cv.Optional(name): validate_pulse_pattern for name in PULSE_PATTERNS}),
+    validate_pattern_presses,
+)
+
+
+def validate_curve_points(value):
+    value = cv.ensure_list(CURVE_POINT_SCHEMA)(value)
+    times = [point[CONF_TIME] for point in value]
+    positions = [point[CONF_POSITION] for point in value]
+    if times != sorted(times) or len(set(times)) != len(times):
+        raise cv.Invalid("Curve points must be given in strictly increasing time")
+    if positions != sorted(positions):
+        raise cv.Invalid("Curve positions must not decrease over time")
+    return value
+
+
+CURVE_POINT_SCHEMA = cv.Schema(
+    {
+        cv.Required(CONF_TIME): cv.percentage,
+        cv.Required(CONF_POSITION): cv.percentage,
+    }
+)
+
+# Reed switch or similar reading true at a known position between the endstops
+POSITION_SENSOR_SCHEMA = cv.Schema(
+    {
+        cv.Required(CONF_SENSOR): cv.use_id(binary_sensor.BinarySensor),
+        cv.Required(CONF_POSITION): cv.percentage,
+    }
+)
+
+# State publish policy; transitions (start, stop, endstop, correction) are always published
+PUBLISH_POLICY_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_MIN_DELTA, default="0%"): cv.percentage,
+        cv.Optional(CONF_MIN_INTERVAL, default="1s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_TRANSITIONS_ONLY, default=False): cv.boolean,
+        cv.Optional(CONF_HEARTBEAT, default="0s"): cv.positive_time_period_milliseconds,
+    }
+)
+
+# Travel curve: either measured points or accel/decel phases, not both
+CURVE_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.declare_id(TravelCurve),
+            cv.Optional(CONF_POINTS): validate_curve_points,
+            cv.Optional(CONF_ACCEL_TIME): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_DECEL_TIME): cv.positive_time_period_milliseconds,
+        }
+    ),
+    cv.has_exactly_one_key(CONF_POINTS, CONF_ACCEL_TIME),
+    cv.has_at_most_one_key(CONF_POINTS, CONF_DECEL_TIME),
+)
+
+
+def validate_curves(config):
+    for curve_key, duration_key in (
+        (CONF_OPEN_CURVE, CONF_OPEN_DURATION),
+        (CONF_CLOSE_CURVE, CONF_CLOSE_DURATION),
+    ):
+        curve = config.get(curve_key)
+        if curve is None or CONF_POINTS in curve:
+            continue
+        ramps = curve[CONF_ACCEL_TIME].total_milliseconds
+        if CONF_DECEL_TIME in curve:
+            ramps += curve[CONF_DECEL_TIME].total_milliseconds
+        if ramps >= config[duration_key].total_milliseconds:
+            raise cv.Invalid(
+                f"{curve_key}: {CONF_ACCEL_TIME} + {CONF_DECEL_TIME} must be shorter than {duration_key}"
+            )
+    return config
+
+
+def validate_sensor_pins(config):
+    for pin_key, sensor_key in (
+        (CONF_OPEN_SENSOR_PIN, CONF_OPEN_SENSOR),
+        (CONF_CLOSE_SENSOR_PIN, CONF_CLOSE_SENSOR),
+    ):
+        if pin_key in config and sensor_key not in config:
+            raise cv.Invalid(f"{pin_key} times the edges of {sensor_key}, which must be set too")
+    return config
+
+
+def validate_current(config):
+    if CONF_STALL_THRESHOLD not in config:
+        return config
+    if CONF_CURRENT_SENSOR not in config:
+        raise cv.Invalid(f"{CONF_STALL_THRESHOLD} needs {CONF_CURRENT_SENSOR}")
+    if config[CONF_STALL_THRESHOLD] <= config[CONF_CURRENT_THRESHOLD]:
+        raise cv.Invalid(f"{CONF_STALL_THRESHOLD} must be above {CONF_CURRENT_THRESHOLD}")
+    return config
+
+
+def validate_ack(config):
+    # Motion is seen by the motor current, the encoder, or the endstop of the end it leaves
+    if CONF_ACK_TIMEOUT not in config:
+        return config
+    if not any(
+        key in config for key in (CONF_CURRENT_SENSOR, CONF_ENCODER_SENSOR, CONF_OPEN_SENSOR, CONF_CLOSE_SENSOR)
+    ):
+        raise cv.Invalid(
+            f"{CONF_ACK_TIMEOUT} needs {CONF_CURRENT_SENSOR}, {CONF_ENCODER_SENSOR} or an endstop sensor"
+        )
+    return config
+
+
+def validate_outputs(config):
+    # Dedicated inputs come as an open/close pair; stops go to stop_output, or cycle output
+    has_direct = CONF_OPEN_OUTPUT in config or CONF_CLOSE_OUTPUT in config
+    if has_direct and (CONF_OPEN_OUTPUT not in config or CONF_CLOSE_OUTPUT not in config):
+        raise cv.Invalid(f"{CONF_OPEN_OUTPUT} and {CONF_CLOSE_OUTPUT} must be set together")
+    if not has_direct and CONF_OUTPUT not in config:
+        raise cv.Invalid(f"{CONF_OUTPUT} is required without {CONF_OPEN_OUTPUT} and {CONF_CLOSE_OUTPUT}")
+    if CONF_STOP_OUTPUT in config and not has_direct:
+        raise cv.Invalid(f"{CONF_STOP_OUTPUT} needs {CONF_OPEN_OUTPUT} and {CONF_CLOSE_OUTPUT}")
+    if has_direct and CONF_STOP_OUTPUT not in config and CONF_OUTPUT not in config:
+        raise cv.Invalid(f"Set {CONF_STOP_OUTPUT}, or {CONF_OUTPUT} to stop the gate")
+    return config
+
 
 # Define unique trigger classes only for impulse-specific events
 SafetyTrigger = impulse_cover_ns.class_("SafetyTrigger", automation.Trigger.template([]))
 
 # Actions
 ResetSafetyAction = impulse_cover_ns.class_("ResetSafetyAction", automation.Action)
+DumpTraceAction = impulse_cover_ns.class_("DumpTraceAction", automation.Action)
 
-CONFIG_SCHEMA = (
-    cover.cover_schema(ImpulseCover)
+CONFIG_SCHEMA = cv.All(
+    cover.cover_schema(TopologyCover)
     .extend(
         {
-            cv.Required(CONF_OUTPUT): cv.use_id(output.BinaryOutput),
+            cv.Optional(CONF_OUTPUT): cv.use_id(output.BinaryOutput),
+            # Dedicated inputs of the controller: one press per command instead of cycling output
+            cv.Optional(CONF_OPEN_OUTPUT): cv.use_id(output.BinaryOutput),
+            cv.Optional(CONF_CLOSE_OUTPUT): cv.use_id(output.BinaryOutput),
+            cv.Optional(CONF_STOP_OUTPUT): cv.use_id(output.BinaryOutput),
             cv.Required(CONF_OPEN_DURATION): cv.positive_time_period_milliseconds,
             cv.Required(CONF_CLOSE_DURATION): cv.positive_time_period_milliseconds,
-            cv.Optional(CONF_PULSE_DELAY, default="500ms"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_PULSE_DELAY, default="500ms"): cv.All(
+                cv.positive_time_period_milliseconds,
+                cv.Range(max=cv.TimePeriod(milliseconds=10000)),
+            ),
+            cv.Optional(CONF_PULSE_PATTERNS, default={}): PULSE_PATTERNS_SCHEMA,
+            cv.Optional(CONF_CONTROLLER_PROFILE, default="open_stop_close_stop"): cv.enum(
+                CONTROLLER_PROFILES, lower=True
+            ),
             cv.Optional(CONF_SAFETY_TIMEOUT, default="60s"): cv.positive_time_period_milliseconds,
             cv.Optional(CONF_SAFETY_MAX_CYCLES, default=5): cv.int_range(min=1, max=20),
+            cv.Optional(CONF_MOTION_MODE, default="polling"): cv.enum(MOTION_MODES, lower=True),
+            cv.Optional(CONF_OPEN_CURVE): CURVE_SCHEMA,
+            cv.Optional(CONF_CLOSE_CURVE): CURVE_SCHEMA,
+            cv.Optional(CONF_OPEN_STOP_LEAD, default="0ms"): cv.All(
+                cv.positive_time_period_milliseconds,
+                cv.Range(max=cv.TimePeriod(milliseconds=3000)),
+            ),
+            cv.Optional(CONF_CLOSE_STOP_LEAD, default="0ms"): cv.All(
+                cv.positive_time_period_milliseconds,
+                cv.Range(max=cv.TimePeriod(milliseconds=3000)),
+            ),
+            cv.Optional(CONF_LEARN_STOP_LEAD, default=False): cv.boolean,
+            cv.Optional(CONF_LEARN_DURATIONS, default=False): cv.boolean,
+            cv.Optional(CONF_MIN_SAVE_INTERVAL, default="60s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_PUBLISH_POLICY, default={}): PUBLISH_POLICY_SCHEMA,
+            # Records in the event trace ring buffer, 8 bytes each; 0 disables
+            cv.Optional(CONF_TRACE_SIZE, default=64): cv.int_range(min=0, max=1024),
+            # Position commands within this window of the first collapse into the last one
+            cv.Optional(CONF_COMMAND_SETTLE, default="0ms"): cv.All(
+                cv.positive_time_period_milliseconds,
+                cv.Range(max=cv.TimePeriod(milliseconds=5000)),
+            ),
+            cv.Optional(CONF_HUB_ID): cv.use_id(ImpulseCoverHub),
+            # Integer motion engine; a compile-time switch for the node, so every impulse
+            # cover must agree on it; on by default where there is no FPU
+            cv.Optional(CONF_FIXED_POINT): cv.boolean,
+            # Timers in fixed slots run from loop() instead of scheduler timeouts, so a
+            # settled node allocates nothing; also compile-time for the node
+            cv.Optional(CONF_ZERO_HEAP, default=False): cv.boolean,
             cv.Optional(CONF_OPEN_SENSOR): cv.use_id(binary_sensor.BinarySensor),
             cv.Optional(CONF_CLOSE_SENSOR): cv.use_id(binary_sensor.BinarySensor),
             cv.Optional(CONF_OPEN_SENSOR_INVERTED, default=False): cv.boolean,
             cv.Optional(CONF_CLOSE_SENSOR_INVERTED, default=False): cv.boolean,
-            # Only unique trigger not available in base ESPHome cover
-            cv.Optional(CONF_ON_SAFETY): automation.validate_automation(
-                {
-                    cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(SafetyTrigger),
-                }
+            # The endstop GPIOs again, timestamped in their interrupt; set `inverted` so they
+            # read true at the endstop
+            cv.Optional(CONF_OPEN_SENSOR_PIN): pins.internal_gpio_input_pin_schema,
+            cv.Optional(CONF_CLOSE_SENSOR_PIN): pins.internal_gpio_input_pin_schema,
+            cv.Optional(CONF_ENDSTOP_DEBOUNCE, default="10ms"): cv.All(
+                cv.positive_time_period_milliseconds,
+                cv.Range(max=cv.TimePeriod(milliseconds=500)),
+            ),
+            # Position fixes between the endstops
+            # Up to ImpulseCover::MAX_POSITION_MARKS
+            cv.Optional(CONF_POSITION_SENSORS): cv.All(
+                cv.ensure_list(POSITION_SENSOR_SCHEMA), cv.Length(max=8)
+            ),
+            cv.Inclusive(CONF_ENCODER_SENSOR, "encoder"): cv.use_id(sensor.Sensor),
+            cv.Inclusive(CONF_ENCODER_COUNTS_PER_TRAVEL, "encoder"): cv.positive_not_null_float,
+            # Motor current, in the sensor's unit; readings at or above the threshold mean it runs
+            cv.Inclusive(CONF_CURRENT_SENSOR, "current"): cv.use_id(sensor.Sensor),
+            cv.Inclusive(CONF_CURRENT_THRESHOLD, "current"): cv.positive_not_null_float,
+            cv.Optional(CONF_CURRENT_START_TIME, default="100ms"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_CURRENT_STOP_TIME, default="300ms"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_STALL_THRESHOLD): cv.positive_not_null_float,
+            cv.Optional(CONF_STALL_TIME, default="500ms"): cv.positive_time_period_milliseconds,
+            # A press that starts the gate is sent again if it shows no motion within this time
+            cv.Optional(CONF_ACK_TIMEOUT): cv.All(
+                cv.positive_time_period_milliseconds,
+                cv.Range(min=cv.TimePeriod(milliseconds=100), max=cv.TimePeriod(milliseconds=10000)),
+            ),
+            cv.Optional(CONF_ACK_RETRIES, default=2): cv.int_range(min=0, max=5),
+            # Only unique trigger not available in base ESPHome cover; up to
+            # ImpulseCover::MAX_TRIGGERS automations
+            cv.Optional(CONF_ON_SAFETY): cv.All(
+                automation.validate_automation(
+                    {
+                        cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(SafetyTrigger),
+                    }
+                ),
+                cv.Length(max=8),
             ),
         }
     )
-    .extend(cv.COMPONENT_SCHEMA)
+    .extend(cv.COMPONENT_SCHEMA),
+    validate_curves,
+    validate_sensor_pins,
+    validate_outputs,
+    validate_current,
+    validate_ack,
+)
+
+
+
+# Build flags for the node switches: one value per node, so every impulse cover must agree
+NODE_SWITCHES = (
+    (CONF_FIXED_POINT, "IMPULSE_COVER_FIXED_POINT"),
+    (CONF_ZERO_HEAP, "IMPULSE_COVER_ZERO_HEAP"),
 )
 
 
+def node_switch(config, key):
+    if key == CONF_FIXED_POINT:
+        return config.get(CONF_FIXED_POINT, CORE.is_esp8266)
+    return config[key]
+
+
+def final_validate_node_switches(config):
+    covers = [
+        conf
+        for conf in fv.full_config.get().get("cover", [])
+        if conf.get(CONF_PLATFORM) == "impulse_cover"
+    ]
+    for key, _ in NODE_SWITCHES:
+        if len({node_switch(conf, key) for conf in covers}) > 1:
+            raise cv.Invalid(
+                f"'{key}' switches how every impulse cover of the node is compiled; "
+                "set it the same way on all of them",
+                path=[key],
+            )
+    return config
+
+
+FINAL_VALIDATE_SCHEMA = final_validate_node_switches
+
+
 async def to_code(config):
-    var = cg.new_Pvariable(config[CONF_ID])
+    topology = SensorTopology.template(
+        CONF_OPEN_SENSOR in config,
+        CONF_CLOSE_SENSOR in config,
+        CONF_OPEN_SENSOR in config and config[CONF_OPEN_SENSOR_INVERTED],
+        CONF_CLOSE_SENSOR in config and config[CONF_CLOSE_SENSOR_INVERTED],
+    )
+    var = cg.new_Pvariable(config[CONF_ID], cg.TemplateArguments(topology))
     await cg.register_component(var, config)
     await cover.register_cover(var, config)
 
@@ -70,23 +426,102 @@ async def to_code(config):
 
     # Set optional parameters
     cg.add(var.set_pulse_delay(config[CONF_PULSE_DELAY]))
+    for name, pattern in PULSE_PATTERNS.items():
+        for step in config[CONF_PULSE_PATTERNS].get(name, []):
+            press = CONF_PRESS in step
+            cg.add(var.add_pulse_step(pattern, press, step[CONF_PRESS if press else CONF_PAUSE]))
+    cg.add(var.set_controller_profile(config[CONF_CONTROLLER_PROFILE]))
     cg.add(var.set_safety_timeout(config[CONF_SAFETY_TIMEOUT]))
     cg.add(var.set_safety_max_cycles(config[CONF_SAFETY_MAX_CYCLES]))
+    cg.add(var.set_motion_mode(config[CONF_MOTION_MODE]))
+    cg.add(var.set_open_stop_lead(config[CONF_OPEN_STOP_LEAD]))
+    cg.add(var.set_close_stop_lead(config[CONF_CLOSE_STOP_LEAD]))
+    cg.add(var.set_learn_stop_lead(config[CONF_LEARN_STOP_LEAD]))
+    cg.add(var.set_learn_durations(config[CONF_LEARN_DURATIONS]))
+    cg.add(var.set_min_save_interval(config[CONF_MIN_SAVE_INTERVAL]))
+    publish_policy = config[CONF_PUBLISH_POLICY]
+    cg.add(var.set_publish_min_delta(publish_policy[CONF_MIN_DELTA]))
+    cg.add(var.set_publish_min_interval(publish_policy[CONF_MIN_INTERVAL]))
+    cg.add(var.set_publish_transitions_only(publish_policy[CONF_TRANSITIONS_ONLY]))
+    cg.add(var.set_publish_heartbeat(publish_policy[CONF_HEARTBEAT]))
+    cg.add(var.set_trace_size(config[CONF_TRACE_SIZE]))
+    cg.add(var.set_command_settle(config[CONF_COMMAND_SETTLE]))
+    # Build flags rather than defines.h: headers such as motion_math.h change their
+    # layout with them and are compiled into translation units that never include it
+    for key, flag in NODE_SWITCHES:
+        if node_switch(config, key):
+            cg.add_build_flag(f"-D{flag}")
+    if CONF_HUB_ID in config:
+        hub = await cg.get_variable(config[CONF_HUB_ID])
+        cg.add(var.set_hub(hub))
+        cg.add(hub.register_cover(var))
 
-    # Set output
-    output_var = await cg.get_variable(config[CONF_OUTPUT])
-    cg.add(var.set_output(output_var))
+    # Set travel curves if provided
+    for curve_key, duration_key, setter in (
+        (CONF_OPEN_CURVE, CONF_OPEN_DURATION, var.set_open_curve),
+        (CONF_CLOSE_CURVE, CONF_CLOSE_DURATION, var.set_close_curve),
+    ):
+        if curve_key not in config:
+            continue
+        curve_config = config[curve_key]
+        curve = cg.new_Pvariable(curve_config[CONF_ID])
+        if CONF_POINTS in curve_config:
+            for point in curve_config[CONF_POINTS]:
+                cg.add(curve.add_point(point[CONF_TIME], point[CONF_POSITION]))
+        else:
+            duration = config[duration_key].total_milliseconds
+            accel = curve_config[CONF_ACCEL_TIME].total_milliseconds / duration
+            decel = curve_config.get(CONF_DECEL_TIME, curve_config[CONF_ACCEL_TIME])
+            cg.add(curve.set_phases(accel, decel.total_milliseconds / duration))
+        cg.add(setter(curve))
+
+    # Set outputs
+    for output_key, setter in (
+        (CONF_OUTPUT, var.set_output),
+        (CONF_OPEN_OUTPUT, var.set_open_output),
+        (CONF_CLOSE_OUTPUT, var.set_close_output),
+        (CONF_STOP_OUTPUT, var.set_stop_output),
+    ):
+        if output_key in config:
+            output_var = await cg.get_variable(config[output_key])
+            cg.add(setter(output_var))
 
     # Set sensors if provided
     if CONF_OPEN_SENSOR in config:
         open_sensor = await cg.get_variable(config[CONF_OPEN_SENSOR])
         cg.add(var.set_open_sensor(open_sensor))
-        cg.add(var.set_open_sensor_inverted(config[CONF_OPEN_SENSOR_INVERTED]))
 
     if CONF_CLOSE_SENSOR in config:
         close_sensor = await cg.get_variable(config[CONF_CLOSE_SENSOR])
         cg.add(var.set_close_sensor(close_sensor))
-        cg.add(var.set_close_sensor_inverted(config[CONF_CLOSE_SENSOR_INVERTED]))
+
+    for pin_key, setter in (
+        (CONF_OPEN_SENSOR_PIN, var.set_open_sensor_pin),
+        (CONF_CLOSE_SENSOR_PIN, var.set_close_sensor_pin),
+    ):
+        if pin_key in config:
+            pin = await cg.gpio_pin_expression(config[pin_key])
+            cg.add(setter(pin))
+    cg.add(var.set_endstop_debounce(config[CONF_ENDSTOP_DEBOUNCE]))
+
+    for mark in config.get(CONF_POSITION_SENSORS, []):
+        mark_sensor = await cg.get_variable(mark[CONF_SENSOR])
+        cg.add(var.add_position_mark(mark_sensor, mark[CONF_POSITION]))
+    if CONF_ENCODER_SENSOR in config:
+        encoder = await cg.get_variable(config[CONF_ENCODER_SENSOR])
+        cg.add(var.set_encoder(encoder, config[CONF_ENCODER_COUNTS_PER_TRAVEL]))
+    if CONF_CURRENT_SENSOR in config:
+        current = await cg.get_variable(config[CONF_CURRENT_SENSOR])
+        cg.add(var.set_current_sensor(current))
+        cg.add(var.set_current_threshold(config[CONF_CURRENT_THRESHOLD]))
+        cg.add(var.set_current_start_time(config[CONF_CURRENT_START_TIME]))
+        cg.add(var.set_current_stop_time(config[CONF_CURRENT_STOP_TIME]))
+        if CONF_STALL_THRESHOLD in config:
+            cg.add(var.set_stall_threshold(config[CONF_STALL_THRESHOLD]))
+        cg.add(var.set_stall_time(config[CONF_STALL_TIME]))
+    if CONF_ACK_TIMEOUT in config:
+        cg.add(var.set_ack_timeout(config[CONF_ACK_TIMEOUT]))
+        cg.add(var.set_ack_retries(config[CONF_ACK_RETRIES]))
 
     # Set up only unique automation trigger (safety) - others are handled by base cover
     for conf in config.get(CONF_ON_SAFETY, []):
@@ -104,3 +539,13 @@ async def to_code(config):
 async def reset_safety_action_to_code(config, action_id, template_arg, _args):
     var = await cg.get_variable(config[CONF_ID])
     return cg.new_Pvariable(action_id, template_arg, var)
+
+
+@automation.register_action(
+    "impulse_cover.dump_trace",
+    DumpTraceAction,
+    cv.Schema({cv.Required(CONF_ID): cv.use_id(ImpulseCover)}),
+)
+async def dump_trace_action_to_code(config, action_id, template_arg, _args):
+    var = await cg.get_variable(config[CONF_ID])
+    return cg.new_Pvariable(action_id, template_arg, var)
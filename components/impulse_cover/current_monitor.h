@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome {
+namespace impulse_cover {
+
+// What a motor current reading completes
+enum CurrentEvent : uint8_t {
+  CURRENT_NONE = 0,
+  CURRENT_START,  // above the threshold for the start time: the motor runs
+  CURRENT_STOP,   // below it for the stop time: the motor stopped
+  CURRENT_STALL,  // above the stall threshold for the stall time
+};
+
+// Debounces motor current readings into motor start, stop and stall. Levels
+// only count once they held for their time, so inrush spikes and the gap of a
+// reversal pass unseen. Times are judged at the readings, so a detection comes
+// up to one sensor update interval after its hold time.
+class CurrentMonitor {
+ public:
+  void set_threshold(float threshold) { this->threshold_ = threshold; }
+  void set_start_time(uint32_t time) { this->start_time_ = time; }
+  void set_stop_time(uint32_t time) { this->stop_time_ = time; }
+  // 0 disables stall detection
+  void set_stall_threshold(float threshold) { this->stall_threshold_ = threshold; }
+  void set_stall_time(uint32_t time) { this->stall_time_ = time; }
+  float get_threshold() const { return this->threshold_; }
+  float get_stall_threshold() const { return this->stall_threshold_; }
+  uint32_t get_start_time() const { return this->start_time_; }
+  uint32_t get_stop_time() const { return this->stop_time_; }
+  uint32_t get_stall_time() const { return this->stall_time_; }
+
+  CurrentEvent update(float current, uint32_t now) {
+    if (this->stall_threshold_ > 0.0f && current >= this->stall_threshold_) {
+      if (!this->stall_pending_) {
+        this->stall_pending_ = true;
+        this->stall_since_ = now;
+      }
+      if (!this->stalled_ && now - this->stall_since_ >= this->stall_time_) {
+        this->stalled_ = true;
+        return CURRENT_STALL;
+      }
+    } else {
+      this->stall_pending_ = false;
+      this->stalled_ = false;
+    }
+
+    const bool above = current >= this->threshold_;
+    if (above == this->running_) {
+      this->pending_ = false;
+      return CURRENT_NONE;
+    }
+    if (!this->pending_) {
+      this->pending_ = true;
+      this->since_ = now;
+    }
+    if (now - this->since_ < (above ? this->start_time_ : this->stop_time_))
+      return CURRENT_NONE;
+    this->running_ = above;
+    this->pending_ = false;
+    this->edge_time_ = this->since_;
+    return above ? CURRENT_START : CURRENT_STOP;
+  }
+
+  bool is_running() const { return this->running_; }
+  // First reading of the level behind the last start or stop
+  uint32_t get_edge_time() const { return this->edge_time_; }
+
+ protected:
+  float threshold_{0.0f};
+  uint32_t start_time_{100};
+  uint32_t stop_time_{300};
+  float stall_threshold_{0.0f};
+  uint32_t stall_time_{500};
+
+  bool running_{false};
+  bool pending_{false};
+  uint32_t since_{0};
+  uint32_t edge_time_{0};
+  bool stall_pending_{false};
+  uint32_t stall_since_{0};
+  bool stalled_{false};
+};
+
+}  // namespace impulse_cover
+}  // namespace esphome
@@ -0,0 +1,46 @@
+#include "endstop_edge.h"
+#include "esphome/core/hal.h"
+
+namespace esphome {
+namespace impulse_cover {
+
+void EndstopEdge::setup(uint32_t debounce_us) {
+  if (this->pin_ == nullptr)
+    return;
+  this->debounce_us_ = debounce_us;
+  this->pin_->setup();
+  this->isr_pin_ = this->pin_->to_isr();
+  this->level_ = this->pin_->digital_read();
+  this->pin_->attach_interrupt(EndstopEdge::gpio_intr, this, gpio::INTERRUPT_ANY_EDGE);
+}
+
+void IRAM_ATTR EndstopEdge::gpio_intr(EndstopEdge *arg) {
+  const uint32_t now = micros();
+  arg->seq_ = arg->seq_ + 1;
+  if (now - arg->last_edge_us_ >= arg->debounce_us_) {
+    // First edge after a quiet period: the contact actually changed here
+    arg->burst_start_us_ = now;
+  }
+  arg->last_edge_us_ = now;
+  arg->level_ = arg->isr_pin_.digital_read();
+  arg->seq_ = arg->seq_ + 1;
+}
+
+bool EndstopEdge::last_activation(uint32_t &time_us) const {
+  // Few tries: the ISR is short, and the caller falls back to millis() anyway
+  for (uint8_t attempt = 0; attempt < 4; attempt++) {
+    const uint32_t seq = this->seq_;
+    if (seq & 1)
+      continue;
+    const uint32_t start = this->burst_start_us_;
+    const bool level = this->level_;
+    if (this->seq_ != seq)
+      continue;
+    time_us = start;
+    return seq != 0 && level;
+  }
+  return false;
+}
+
+}  // namespace impulse_cover
+}  // namespace esphome
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "esphome/core/gpio.h"
+#include <cstdint>
+
+namespace esphome {
+namespace impulse_cover {
+
+// Endstop edge timestamps taken in the GPIO interrupt, ahead of binary sensor
+// filters and main loop latency. Edges closer together than the debounce time
+// form one bounce burst, timestamped at its first edge. The ISR is the only
+// writer and readers retry on the sequence counter, so neither side blocks.
+class EndstopEdge {
+ public:
+  void set_pin(InternalGPIOPin *pin) { this->pin_ = pin; }
+  bool is_configured() const { return this->pin_ != nullptr; }
+  InternalGPIOPin *get_pin() const { return this->pin_; }
+
+  void setup(uint32_t debounce_us);
+  // micros() at the start of the last edge burst, if the input has been active since
+  bool last_activation(uint32_t &time_us) const;
+
+ protected:
+  static void gpio_intr(EndstopEdge *arg);
+
+  InternalGPIOPin *pin_{nullptr};
+  ISRInternalGPIOPin isr_pin_;
+  uint32_t debounce_us_{0};
+  volatile uint32_t seq_{0};  // odd while the ISR writes
+  volatile uint32_t burst_start_us_{0};
+  volatile uint32_t last_edge_us_{0};
+  volatile bool level_{false};  // input level after the last edge
+};
+
+}  // namespace impulse_cover
+}  // namespace esphome
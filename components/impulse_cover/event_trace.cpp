@@ -0,0 +1,73 @@
+#include "event_trace.h"
+
+namespace esphome {
+namespace impulse_cover {
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+static char *put_hex_(char *out, uint32_t value, uint8_t bytes) {
+  for (uint8_t i = 0; i < bytes; i++) {
+    const uint8_t byte = (value >> (8 * i)) & 0xFF;
+    *out++ = HEX_DIGITS[byte >> 4];
+    *out++ = HEX_DIGITS[byte & 0x0F];
+  }
+  return out;
+}
+
+static int hex_value_(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+static bool get_hex_(const char *&in, uint8_t bytes, uint32_t &value) {
+  value = 0;
+  for (uint8_t i = 0; i < bytes; i++) {
+    const int hi = hex_value_(in[0]);
+    const int lo = hi < 0 ? -1 : hex_value_(in[1]);
+    if (lo < 0)
+      return false;
+    value |= static_cast<uint32_t>(hi << 4 | lo) << (8 * i);
+    in += 2;
+  }
+  return true;
+}
+
+void EventTrace::init(uint16_t capacity) {
+  this->records_.reset(capacity != 0 ? new TraceRecord[capacity] : nullptr);
+  this->capacity_ = capacity;
+  this->head_ = 0;
+  this->total_ = 0;
+}
+
+uint16_t EventTrace::encode_line(uint16_t first, char *buf) const {
+  uint16_t count = 0;
+  char *out = buf;
+  while (count < RECORDS_PER_LINE && first + count < this->size()) {
+    const TraceRecord &rec = this->at(first + count);
+    out = put_hex_(out, rec.time, 4);
+    out = put_hex_(out, rec.event, 1);
+    out = put_hex_(out, rec.arg, 1);
+    out = put_hex_(out, rec.value, 2);
+    count++;
+  }
+  *out = '\0';
+  return count;
+}
+
+uint16_t EventTrace::decode_line(const char *hex, TraceRecord *out, uint16_t max) {
+  uint16_t count = 0;
+  uint32_t time, event, arg, value;
+  while (count < max && get_hex_(hex, 4, time) && get_hex_(hex, 1, event) && get_hex_(hex, 1, arg) &&
+         get_hex_(hex, 2, value)) {
+    out[count++] = {time, static_cast<uint8_t>(event), static_cast<uint8_t>(arg), static_cast<uint16_t>(value)};
+  }
+  return count;
+}
+
+}  // namespace impulse_cover
+}  // namespace esphome
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace esphome {
+namespace impulse_cover {
+
+// Record types; the numbering is part of the dump format, append only.
+enum TraceEvent : uint8_t {
+  TRACE_BOOT = 0,    // value: restored position
+  TRACE_COMMAND,     // arg: TraceCommand, value: requested position
+  TRACE_OPERATION,   // arg: cover operation entered, value: position
+  TRACE_PULSE,       // arg: 1 relay on, 0 relay off; value: PulseOutput
+  TRACE_SENSOR,      // arg: 0 open / 1 close endstop, value: raw sensor state
+  TRACE_CORRECTION,  // value: position after a sensor correction
+  TRACE_TARGET,      // value: position at which the target was reached
+  TRACE_SAFETY,      // arg: TraceSafety, value: cycle count
+  TRACE_CURRENT,     // arg: CurrentEvent, value: motor current reading x100
+  TRACE_ACK,         // arg: TraceAck, value: ms since the press (seen) or retries so far (missed)
+};
+
+enum TraceCommand : uint8_t {
+  TRACE_COMMAND_STOP = 0,
+  TRACE_COMMAND_TOGGLE,
+  TRACE_COMMAND_POSITION,
+  TRACE_COMMAND_RESET_SAFETY,
+};
+
+enum TraceAck : uint8_t {
+  TRACE_ACK_SEEN = 0,  // the gate moved after the press
+  TRACE_ACK_MISSED,    // it did not within ack_timeout
+};
+
+enum TraceSafety : uint8_t {
+  TRACE_SAFETY_CYCLES = 0,
+  TRACE_SAFETY_TIMEOUT,
+  TRACE_SAFETY_STALL,
+};
+
+// 8 bytes; dumped little-endian as time, event, arg, value
+struct TraceRecord {
+  uint32_t time;  // millis()
+  uint8_t event;
+  uint8_t arg;
+  uint16_t value;
+};
+
+// Fixed-size ring of compact binary records. The buffer is allocated once by
+// init(); record() is a few stores and never logs or allocates, so tracing
+// can stay enabled in the field without changing timing.
+class EventTrace {
+ public:
+  static const uint16_t RECORDS_PER_LINE = 8;
+
+  void init(uint16_t capacity);
+  bool enabled() const { return this->capacity_ != 0; }
+
+  void record(uint32_t time, TraceEvent event, uint8_t arg, uint16_t value) {
+    if (this->capacity_ == 0)
+      return;
+    this->records_[this->head_] = {time, event, arg, value};
+    this->head_ = this->head_ + 1 == this->capacity_ ? 0 : this->head_ + 1;
+    this->total_++;
+  }
+
+  // Positions are stored in 1/10000 steps
+  static uint16_t encode_position(float position) { return static_cast<uint16_t>(position * 10000.0f + 0.5f); }
+  static float decode_position(uint16_t value) { return value / 10000.0f; }
+
+  uint16_t size() const { return this->total_ < this->capacity_ ? this->total_ : this->capacity_; }
+  uint32_t dropped() const { return this->total_ - this->size(); }
+  // i-th retained record, oldest first
+  const TraceRecord &at(uint16_t i) const {
+    const uint16_t first = this->total_ < this->capacity_ ? 0 : this->head_;
+    const uint32_t index = first + i;
+    return this->records_[index < this->capacity_ ? index : index - this->capacity_];
+  }
+
+  // Hex encoding of up to RECORDS_PER_LINE records starting at `first`; buf
+  // must hold 16 * RECORDS_PER_LINE + 1 chars. Returns the records written.
+  uint16_t encode_line(uint16_t first, char *buf) const;
+  // Inverse of encode_line() for host tools; returns the records decoded.
+  static uint16_t decode_line(const char *hex, TraceRecord *out, uint16_t max);
+
+ protected:
+  std::unique_ptr<TraceRecord[]> records_;
+  uint16_t capacity_{0};
+  uint16_t head_{0};
+  uint32_t total_{0};
+};
+
+}  // namespace impulse_cover
+}  // namespace esphome
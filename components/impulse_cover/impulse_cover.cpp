@@ -1,32 +1,112 @@
 #include "impulse_cover.h"
+#include "esphome/core/helpers.h"
 #include "esphome/core/log.h"
 #include "esphome/core/hal.h"
 #include "esphome/core/application.h"
-#ifdef USE_BINARY_SENSOR
-#include "esphome/components/binary_sensor/binary_sensor.h"
+#ifdef USE_SENSOR
+#include "esphome/components/sensor/sensor.h"
+#endif
+#ifdef USE_TEXT_SENSOR
+#include "esphome/components/text_sensor/text_sensor.h"
 #endif
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 
 namespace esphome {
 namespace impulse_cover {
 
 static const char *const TAG = "impulse_cover";
 
+static const uint32_t LEARNED_STATE_HASH = 0x1A7E57A7;
+static const float STOP_LEAD_MAX_MS = 3000.0f;  // larger observed errors are not coast
+static const float STOP_LEAD_GAIN = 0.5f;       // share of each observed error applied
+static const float DURATION_GAIN = 0.25f;       // EMA weight of a new full-run time
+static const float DURATION_OUTLIER = 0.15f;    // max deviation from the recent median
+static const float DURATION_BOUND = 0.5f;       // max deviation from the configured duration
+static const uint32_t ENDSTOP_EDGE_MAX_AGE = 1000;  // ms; older interrupt edges belong to another callback
+static const float FIX_CORRECTION = 0.01f;       // position fixes moving the estimate further are corrections
+static const float MOTOR_STOP_END_BAND = 0.1f;   // an unasked motor stop this close to an end is the end
+static const float MOTOR_STOP_END_RUN = 0.8f;    // or one after this share of a full run
+
 using namespace esphome::cover;
 
+static const char *pulse_pattern_to_str(PulsePattern pattern) {
+  switch (pattern) {
+    case PULSE_SINGLE:
+      return "single";
+    case PULSE_DOUBLE:
+      return "double";
+    case PULSE_STOP:
+      return "stop";
+    default:
+      return "unknown";
+  }
+}
+
+static const char *pulse_output_to_str(PulseOutput output) {
+  switch (output) {
+    case PULSE_OUTPUT_IMPULSE:
+      return "impulse";
+    case PULSE_OUTPUT_OPEN:
+      return "open";
+    case PULSE_OUTPUT_CLOSE:
+      return "close";
+    case PULSE_OUTPUT_STOP:
+      return "stop";
+    default:
+      return "unknown";
+  }
+}
+
+static const char *controller_profile_to_str(ControllerProfile profile) {
+  switch (profile) {
+    case CONTROLLER_OPEN_STOP_CLOSE_STOP:
+      return "open_stop_close_stop";
+    case CONTROLLER_OPEN_STOP_CLOSE:
+      return "open_stop_close";
+    case CONTROLLER_OPEN_CLOSE_OPEN:
+      return "open_close_open";
+    default:
+      return "unknown";
+  }
+}
+
+static const char *controller_state_to_str(ControllerState state) {
+  switch (state) {
+    case CONTROLLER_STOPPED_NEXT_OPEN:
+      return "stopped (next open)";
+    case CONTROLLER_STOPPED_NEXT_CLOSE:
+      return "stopped (next close)";
+    case CONTROLLER_OPENING:
+      return "opening";
+    case CONTROLLER_CLOSING:
+      return "closing";
+    default:
+      return "unknown";
+  }
+}
+
 void ImpulseCover::setup() {
   ESP_LOGCONFIG(TAG, "Setting up Impulse Cover...");
+  this->event_trace_.init(this->trace_size_);
+  this->init_pulse_patterns_();
   
-  if (this->output_ == nullptr) {
-    ESP_LOGE(TAG, "Output is required!");
+  if (this->outputs_[PULSE_OUTPUT_IMPULSE] == nullptr &&
+      (this->outputs_[PULSE_OUTPUT_OPEN] == nullptr || this->outputs_[PULSE_OUTPUT_CLOSE] == nullptr)) {
+    ESP_LOGE(TAG, "Output, or open and close outputs, required!");
     this->mark_failed();
     return;
   }
   
-  // Initialize state
+  // Initialize state; endstop callbacks may already have run and "saved" before rtc_ existed
   auto restore = this->restore_state_();
+  this->saved_position_ = -1.0f;
+  this->has_saved_ = false;
+  this->state_saves_ = 0;
   if (restore.has_value()) {
     restore->apply(this);
+    this->saved_position_ = restore->position;
   } else {
     this->position = 0.5f;  // Default to half open if no restore state
   }
@@ -35,19 +115,99 @@ void ImpulseCover::setup() {
   this->current_trigger_operation_ = COVER_OPERATION_IDLE;
 
 #ifdef USE_BINARY_SENSOR
+  for (auto &edge : this->endstop_edges_) {
+    edge.setup(this->endstop_debounce_ * 1000);
+  }
+  
   // Initialize position from sensors if available
   ESP_LOGV(TAG, "Initializing position from sensors...");
   this->update_position_from_sensors_(true);
 #endif
   
-  this->start_dir_time_ = this->last_recompute_time_ = millis();
+  if (this->open_curve_ != nullptr) {
+    this->open_curve_->setup();
+  }
+  if (this->close_curve_ != nullptr) {
+    this->close_curve_->setup();
+  }
+  
+  this->configured_open_duration_ = this->open_duration_;
+  this->configured_close_duration_ = this->close_duration_;
+  this->learned_pref_ = global_preferences->make_preference<LearnedState>(this->get_object_id_hash() ^
+                                                                          LEARNED_STATE_HASH);
+  LearnedState learned{};
+  if ((this->learn_stop_lead_ || this->learn_durations_) && this->learned_pref_.load(&learned)) {
+    if (this->learn_stop_lead_) {
+      this->open_stop_lead_ = learned.open_stop_lead;
+      this->close_stop_lead_ = learned.close_stop_lead;
+      ESP_LOGD(TAG, "Restored stop lead: open %.0fms, close %.0fms", this->open_stop_lead_, this->close_stop_lead_);
+    }
+    // Durations learned against a different configuration are dropped
+    if (this->learn_durations_ &&
+        std::fabs(float(learned.open_duration) - this->open_duration_) <= DURATION_BOUND * this->open_duration_ &&
+        std::fabs(float(learned.close_duration) - this->close_duration_) <= DURATION_BOUND * this->close_duration_) {
+      this->open_duration_ = learned.open_duration;
+      this->close_duration_ = learned.close_duration;
+      ESP_LOGD(TAG, "Restored durations: open %ums, close %ums", this->open_duration_, this->close_duration_);
+    }
+  }
+  this->publish_diagnostics_();
+  
+  // At rest after boot; between the ends the next press is taken to reverse the last move
+  if (this->position >= COVER_OPEN || this->position <= COVER_CLOSED) {
+    this->controller_.at_end(this->position >= COVER_OPEN);
+  } else {
+    this->controller_.at_end(this->last_operation_ == COVER_OPERATION_OPENING);
+  }
+  
+  this->start_dir_time_ = millis();
+  this->start_position_ = this->position;
+  this->feedback_.rebase(to_motion(this->position));
+  this->trace_(TRACE_BOOT, 0, EventTrace::encode_position(this->position));
 #ifdef USE_BINARY_SENSOR
   this->last_sensor_check_time_ = millis();
 #endif
+
+  if (this->motion_mode_ == MOTION_MODE_EVENT || this->hub_ != nullptr) {
+    // Everything loop() would poll is driven by scheduler deadlines instead, or the
+    // hub calls poll() while the cover moves
+#ifdef USE_BINARY_SENSOR
+    this->set_interval("sensor_check", this->safety_timeout_, [this]() {
+      if (this->current_operation == COVER_OPERATION_IDLE) {
+        this->check_sensor_alignment_();
+      }
+    });
+#endif
+    this->disable_loop();
+  }
+  if (this->publish_heartbeat_ > 0) {
+    this->set_interval("publish_heartbeat", this->publish_heartbeat_, [this]() {
+      this->recompute_position_();
+      this->publish_state_(PUBLISH_HEARTBEAT);
+    });
+  }
   ESP_LOGCONFIG(TAG, "Impulse Cover setup complete");
 }
 
 void ImpulseCover::loop() {
+#ifdef IMPULSE_COVER_ZERO_HEAP
+  const uint32_t now = millis();
+  int8_t id;
+  while ((id = this->timers_.pop_due(now)) >= 0) {
+    this->on_timer_(static_cast<TimerId>(id));
+  }
+  if (this->motion_mode_ == MOTION_MODE_EVENT || this->hub_ != nullptr) {
+    // Only woken for the timer slots; the hub polls a moving cover itself
+    if (!this->timers_.any()) {
+      this->disable_loop();
+    }
+    return;
+  }
+#endif
+  this->poll();
+}
+
+void ImpulseCover::poll() {
   const uint32_t now = millis();
   
   if (this->current_operation == COVER_OPERATION_IDLE) {
@@ -60,6 +220,7 @@ void ImpulseCover::loop() {
 #endif
     return;
   }
+  const uint32_t loop_start = micros();
     
   // Recompute position every loop cycle
   this->recompute_position_();
@@ -70,31 +231,14 @@ void ImpulseCover::loop() {
   // If we initiated the move, check if we reached target or safety limits
   if (this->current_trigger_operation_ != COVER_OPERATION_IDLE) {
     if (this->is_at_target_()) {
-      ESP_LOGI(TAG, "Target position reached, stopping movement");
-      
-      // In impulse mode, only send stop pulse for intermediate positions
-      // Final positions (fully open/closed) will stop automatically at endstops
-      bool is_intermediate_target = (this->target_position_ > COVER_CLOSED + 0.00f && 
-                                   this->target_position_ < COVER_OPEN - 0.00f);
-      
-      if (is_intermediate_target) {
-        ESP_LOGD(TAG, "Intermediate target - sending stop pulse");
-        this->start_direction_(COVER_OPERATION_IDLE);
-      } else {
-        ESP_LOGV(TAG, "Final position target - no stop pulse needed");
-        this->set_current_operation_(COVER_OPERATION_IDLE, false);
-      }
+      this->on_target_reached_();
     } else if (now - this->start_dir_time_ > this->safety_timeout_) {
-      ESP_LOGW(TAG, "Safety timeout reached, stopping movement");
-      this->set_current_operation_(COVER_OPERATION_IDLE, false);
+      this->on_safety_timeout_();
     }
   }
   
-  // Publish state at regular intervals
-  if (now - this->last_publish_time_ > 1000) {  // Every 1 second
-    this->publish_state(false);
-    this->last_publish_time_ = now;
-  }
+  this->publish_state_(PUBLISH_PROGRESS);
+  this->stats_.loop_time.add(micros() - loop_start);
 }
 
 void ImpulseCover::dump_config() {
@@ -102,21 +246,115 @@ void ImpulseCover::dump_config() {
   ESP_LOGCONFIG(TAG, "  Open Duration: %ums", this->open_duration_);
   ESP_LOGCONFIG(TAG, "  Close Duration: %ums", this->close_duration_);
   ESP_LOGCONFIG(TAG, "  Pulse Delay: %ums", this->pulse_delay_);
+  for (uint8_t p = 0; p < PULSE_PATTERN_COUNT; p++) {
+    const PulsePattern pattern = static_cast<PulsePattern>(p);
+    char buf[128];
+    size_t len = 0;
+    for (uint8_t i = 0; i < this->pulse_sequencer_.get_step_count(pattern) && len < sizeof(buf); i++) {
+      const PulseStep &step = this->pulse_sequencer_.get_step(pattern, i);
+      len += snprintf(buf + len, sizeof(buf) - len, "%s%s %ums", i == 0 ? "" : ", ", step.press ? "press" : "pause",
+                      (unsigned) step.duration);
+    }
+    buf[std::min(len, sizeof(buf) - 1)] = '\0';
+    ESP_LOGCONFIG(TAG, "  Pulse Pattern %s: %s", pulse_pattern_to_str(pattern), buf);
+  }
+  ESP_LOGCONFIG(TAG, "  Controller Profile: %s", controller_profile_to_str(this->controller_.get_profile()));
+  char outputs[32] = "";
+  size_t outputs_len = 0;
+  for (uint8_t o = 0; o < PULSE_OUTPUT_COUNT; o++) {
+    if (this->outputs_[o] != nullptr) {
+      outputs_len += snprintf(outputs + outputs_len, sizeof(outputs) - outputs_len, outputs_len == 0 ? "%s" : ", %s",
+                              pulse_output_to_str(static_cast<PulseOutput>(o)));
+    }
+  }
+  ESP_LOGCONFIG(TAG, "  Outputs: %s", outputs);
   ESP_LOGCONFIG(TAG, "  Safety Timeout: %ums", this->safety_timeout_);
   ESP_LOGCONFIG(TAG, "  Safety Max Cycles: %u", this->safety_max_cycles_);
+  ESP_LOGCONFIG(TAG, "  Motion Mode: %s%s", this->motion_mode_ == MOTION_MODE_EVENT ? "event" : "polling",
+                this->hub_ != nullptr ? " (hub)" : "");
+  ESP_LOGCONFIG(TAG, "  Open Curve: %s", this->open_curve_ != nullptr ? "custom" : "linear");
+  ESP_LOGCONFIG(TAG, "  Close Curve: %s", this->close_curve_ != nullptr ? "custom" : "linear");
+  ESP_LOGCONFIG(TAG, "  Stop Lead: open %.0fms, close %.0fms (learning: %s)", this->open_stop_lead_,
+                this->close_stop_lead_, this->learn_stop_lead_ ? "YES" : "NO");
+  ESP_LOGCONFIG(TAG, "  Learn Durations: %s", this->learn_durations_ ? "YES" : "NO");
+  ESP_LOGCONFIG(TAG, "  Min Save Interval: %ums", this->min_save_interval_);
+  ESP_LOGCONFIG(TAG, "  Trace: %u records", this->trace_size_);
+  ESP_LOGCONFIG(TAG, "  Command Settle: %ums", this->command_settle_);
+  if (this->ack_timeout_ > 0) {
+    ESP_LOGCONFIG(TAG, "  Press Acknowledgement: within %ums, %u retries", this->ack_timeout_, this->ack_retries_);
+  }
+  ESP_LOGCONFIG(TAG, "  Publish: min delta %.1f%%, min interval %ums, transitions only %s, heartbeat %ums",
+                this->publish_min_delta_ * 100.0f, this->publish_min_interval_,
+                this->publish_transitions_only_ ? "YES" : "NO", this->publish_heartbeat_);
+  const PerfStats &stats = this->stats_;
+  ESP_LOGCONFIG(TAG,
+                "  Counters: pulses %u (double %u, deferred %u), safety trips %u, corrections %u, arrivals %u, "
+                "coalesced commands %u, missed presses %u",
+                stats.pulses, stats.double_pulses, stats.deferred_pulses, stats.safety_trips, stats.corrections,
+                stats.endstop_arrivals, stats.coalesced_commands, stats.missed_presses);
+  const struct {
+    const char *name;
+    const Histogram &hist;
+    const char *unit;
+  } histograms[] = {
+      {"Loop Time", stats.loop_time, "us"},
+      {"Command Latency", stats.command_latency, "ms"},
+      {"Pulse Jitter", stats.pulse_jitter, "ms"},
+      {"Arrival Error", stats.arrival_error, "ms"},
+      {"Endstop Delay", stats.endstop_delay, "ms"},
+      {"Ack Latency", stats.ack_latency, "ms"},
+  };
+  for (const auto &h : histograms) {
+    ESP_LOGCONFIG(TAG, "  %s: n=%u, p50 %u%s, p95 %u%s, max %u%s", h.name, h.hist.count(), h.hist.percentile(0.5f),
+                  h.unit, h.hist.percentile(0.95f), h.unit, h.hist.max(), h.unit);
+  }
   
+#ifdef USE_BINARY_SENSOR
+  for (uint8_t i = 0; i < this->mark_count_; i++) {
+    ESP_LOGCONFIG(TAG, "  Position Mark: %.1f%%", from_motion(this->mark_positions_[i]) * 100.0f);
+  }
+#endif
+#ifdef USE_SENSOR
+  if (this->encoder_sensor_ != nullptr) {
+    ESP_LOGCONFIG(TAG, "  Encoder: %s (%.0f counts per travel)", this->encoder_sensor_->get_name().c_str(),
+                  this->feedback_.get_counts_per_travel());
+  }
+  if (this->current_sensor_ != nullptr) {
+    const CurrentMonitor &monitor = this->current_monitor_;
+    ESP_LOGCONFIG(TAG, "  Current Sensor: %s (threshold %.2f, start %ums, stop %ums)",
+                  this->current_sensor_->get_name().c_str(), monitor.get_threshold(), monitor.get_start_time(),
+                  monitor.get_stop_time());
+    if (monitor.get_stall_threshold() > 0.0f) {
+      ESP_LOGCONFIG(TAG, "  Stall: above %.2f for %ums", monitor.get_stall_threshold(), monitor.get_stall_time());
+    }
+  }
+#endif
 #ifdef USE_BINARY_SENSOR
   if (this->open_sensor_) {
     ESP_LOGCONFIG(TAG, "  Open Sensor: %s", this->open_sensor_->get_name().c_str());
-    ESP_LOGCONFIG(TAG, "  Open Sensor Inverted: %s", this->open_sensor_inverted_ ? "YES" : "NO");
+    ESP_LOGCONFIG(TAG, "  Open Sensor Inverted: %s", this->sensor_inverted_(true) ? "YES" : "NO");
   }
   if (this->close_sensor_) {
     ESP_LOGCONFIG(TAG, "  Close Sensor: %s", this->close_sensor_->get_name().c_str());
-    ESP_LOGCONFIG(TAG, "  Close Sensor Inverted: %s", this->close_sensor_inverted_ ? "YES" : "NO");
+    ESP_LOGCONFIG(TAG, "  Close Sensor Inverted: %s", this->sensor_inverted_(false) ? "YES" : "NO");
+  }
+  LOG_PIN("  Open Sensor Pin: ", this->endstop_edges_[0].get_pin());
+  LOG_PIN("  Close Sensor Pin: ", this->endstop_edges_[1].get_pin());
+  if (this->endstop_edges_[0].is_configured() || this->endstop_edges_[1].is_configured()) {
+    ESP_LOGCONFIG(TAG, "  Endstop Debounce: %ums", this->endstop_debounce_);
   }
 #endif
 }
 
+void ImpulseCover::on_shutdown() {
+  // Whatever is still coalesced goes out now, even mid-move
+  this->recompute_position_();
+  this->flush_saves_();
+  global_preferences->sync();
+}
+
+void ImpulseCover::on_safe_shutdown() { this->on_shutdown(); }
+
 cover::CoverTraits ImpulseCover::get_traits() {
   auto traits = cover::CoverTraits();
   traits.set_supports_position(true);
@@ -136,6 +374,17 @@ void ImpulseCover::control(const cover::CoverCall &call) {
            call.get_toggle().has_value() ? "true" : "false",
            call.get_position().has_value() ? "true" : "false");
   
+  if (call.get_stop()) {
+    this->trace_(TRACE_COMMAND, TRACE_COMMAND_STOP, 0);
+  } else if (call.get_toggle().has_value()) {
+    this->trace_(TRACE_COMMAND, TRACE_COMMAND_TOGGLE, 0);
+  } else if (call.get_position().has_value()) {
+    this->trace_(TRACE_COMMAND, TRACE_COMMAND_POSITION, EventTrace::encode_position(*call.get_position()));
+  }
+
+  // Bring the estimate up to date; in event mode nothing else does between publishes
+  this->recompute_position_();
+  
   if (call.get_position().has_value()) {
     ESP_LOGV(TAG, "Position command: %.3f (current: %.3f)", 
              *call.get_position(), this->position);
@@ -145,24 +394,32 @@ void ImpulseCover::control(const cover::CoverCall &call) {
     ESP_LOGW(TAG, "Cover is in safety mode, ignoring command");
     return;
   }
+  if (!this->command_queued_) {
+    // Latency of a coalesced burst runs from its first command
+    this->command_time_ = millis();
+  }
+  this->command_pending_ = true;
+  this->ack_attempts_ = 0;
 
   // Stop action logic
   if (call.get_stop()) {
     ESP_LOGI(TAG, "Stop command received");
+    this->cancel_queued_command_();
     this->start_direction_(COVER_OPERATION_IDLE);
     return;
   }
   
   // Toggle action logic
   if (call.get_toggle().has_value()) {
+    this->cancel_queued_command_();
     if (this->current_trigger_operation_ != COVER_OPERATION_IDLE) {
       this->start_direction_(COVER_OPERATION_IDLE);
     } else {
       if (this->position == COVER_CLOSED || this->last_operation_ == COVER_OPERATION_CLOSING) {
-        this->target_position_ = COVER_OPEN;
+        this->target_position_ = MOTION_ONE;
         this->start_direction_(COVER_OPERATION_OPENING);
       } else {
-        this->target_position_ = COVER_CLOSED;
+        this->target_position_ = 0;
         this->start_direction_(COVER_OPERATION_CLOSING);
       }
     }
@@ -171,19 +428,71 @@ void ImpulseCover::control(const cover::CoverCall &call) {
 
   // Position command
   if (call.get_position().has_value()) {
-    auto pos = *call.get_position();
-    if (pos == this->position) {
-      // Already at target
-      if (this->current_operation != COVER_OPERATION_IDLE || 
-          this->current_trigger_operation_ != COVER_OPERATION_IDLE) {
-        this->start_direction_(COVER_OPERATION_IDLE);
-      }
+    const float pos = *call.get_position();
+    if (this->command_settle_ == 0) {
+      this->move_to_(pos);
+      return;
+    }
+    // Latest wins until the window closes; only then are pulses planned
+    if (this->command_queued_) {
+      ESP_LOGV(TAG, "Position %.3f supersedes queued %.3f", pos, this->queued_position_);
+      this->stats_.coalesced_commands++;
     } else {
-      this->target_position_ = pos;
-      this->start_direction_(pos < this->position ? COVER_OPERATION_CLOSING : COVER_OPERATION_OPENING);
+      this->command_queued_ = true;
+      this->arm_timer_(TIMER_COMMAND_SETTLE, this->command_settle_);
+    }
+    this->queued_position_ = pos;
+    return;
+  }
+}
+
+void ImpulseCover::move_to_(float pos) {
+  const motion_t target = to_motion(pos);
+  const motion_t position = to_motion(this->position);
+  if (target == position) {
+    // Already at target
+    if (this->current_operation != COVER_OPERATION_IDLE || 
+        this->current_trigger_operation_ != COVER_OPERATION_IDLE) {
+      this->start_direction_(COVER_OPERATION_IDLE);
+    }
+    return;
+  }
+  
+  const CoverOperation dir = target < position ? COVER_OPERATION_CLOSING : COVER_OPERATION_OPENING;
+  this->target_position_ = target;
+  if (this->is_intermediate_target_() && !this->can_stop_()) {
+    // This controller only stops at the ends
+    ESP_LOGD(TAG, "Controller cannot stop mid-travel, moving to the end instead of %.3f", pos);
+    this->target_position_ = dir == COVER_OPERATION_OPENING ? MOTION_ONE : 0;
+  }
+  if (this->current_operation == dir && this->current_trigger_operation_ == dir) {
+    // Already running that way: a new target, no pulse
+    ESP_LOGD(TAG, "Moving towards new target %.3f", pos);
+    this->command_pending_ = false;
+    this->publish_trajectory_();
+    if (this->motion_mode_ == MOTION_MODE_EVENT) {
+      this->arm_target_timer_();
     }
     return;
   }
+  this->start_direction_(dir);
+}
+
+void ImpulseCover::apply_queued_command_() {
+  this->command_queued_ = false;
+  if (this->safety_triggered_) {
+    return;
+  }
+  this->recompute_position_();
+  this->command_pending_ = true;
+  this->move_to_(this->queued_position_);
+}
+
+void ImpulseCover::cancel_queued_command_() {
+  if (this->command_queued_) {
+    this->cancel_timer_(TIMER_COMMAND_SETTLE);
+    this->command_queued_ = false;
+  }
 }
 
 // Main control methods based on impulse cover logic
@@ -195,73 +504,107 @@ void ImpulseCover::start_direction_(cover::CoverOperation dir) {
     ESP_LOGW(TAG, "Cannot start movement: safety triggered");
     return;
   }
+  if (this->lead_in_ && (dir != COVER_OPERATION_IDLE || this->current_operation != COVER_OPERATION_IDLE)) {
+    this->end_lead_in_();
+  }
+  // Whatever the last press did, the plan starts from the tracked state
+  this->cancel_ack_();
 
-  // Determine what type of pulse to send based on current state and desired operation
-  bool send_pulse = false;
-  bool send_double_pulse = false;
-  
   ESP_LOGV(TAG, "Current position: %.3f, target: %.3f, current_operation: %d, last_operation_: %d", 
-           this->position, this->target_position_, 
+           this->position, from_motion(this->target_position_), 
            static_cast<int>(this->current_operation), static_cast<int>(this->last_operation_));
   
+  // Auto-reset safety cycle count after period of inactivity; start_dir_time_ is
+  // when the cover went idle
+  if (this->current_operation == COVER_OPERATION_IDLE && 
+      this->safety_cycle_count_ > 0 && 
+      (millis() - this->start_dir_time_) > 30000) {
+    ESP_LOGV(TAG, "Auto-resetting safety cycle count after inactivity");
+    this->safety_cycle_count_ = 0;
+  }
+  
+  // The presses follow from the controller's tracked state and its profile
+  PulsePlan plan{};
+  PulseOutput output = PULSE_OUTPUT_IMPULSE;
+  bool planned = false;
+  const ControllerGoal goal = dir == COVER_OPERATION_OPENING   ? CONTROLLER_GOAL_OPEN
+                              : dir == COVER_OPERATION_CLOSING ? CONTROLLER_GOAL_CLOSE
+                                                               : CONTROLLER_GOAL_STOP;
   if (dir == COVER_OPERATION_IDLE) {
-    // Stop command
     if (this->current_operation != COVER_OPERATION_IDLE) {
-      ESP_LOGD(TAG, "Stopping movement - sending single pulse");
-      send_pulse = true;
-    }
-  } else if (dir == COVER_OPERATION_OPENING) {
-    if (this->position >= COVER_OPEN - 0.00f) {
-      // Already fully open - nothing to do
-      ESP_LOGV(TAG, "Already fully open - no pulse needed");
-    } else if (this->position <= COVER_CLOSED + 0.00f) {
-      // Fully closed, want to open - single pulse
-      ESP_LOGD(TAG, "Closed to open - sending single pulse");
-      send_pulse = true;
-    } else {
-      // Partially open
-      if (this->last_operation_ != COVER_OPERATION_OPENING) {
-        // Different direction from previous - single pulse
-        ESP_LOGD(TAG, "Partial position, direction change - sending single pulse");
-        send_pulse = true;
-      } else {
-        // Same direction as before - double pulse
-        ESP_LOGD(TAG, "Partial position, same direction - sending double pulse");
-        send_double_pulse = true;
-      }
-    }
-  } else if (dir == COVER_OPERATION_CLOSING) {
-    if (this->position <= COVER_CLOSED + 0.00f) {
-      // Already fully closed - nothing to do
-      ESP_LOGV(TAG, "Already fully closed - no pulse needed");
-    } else if (this->position >= COVER_OPEN - 0.00f) {
-      // Fully open, want to close - single pulse
-      ESP_LOGD(TAG, "Open to close - sending single pulse");
-      send_pulse = true;
-    } else {
-      // Partially open
-      if (this->last_operation_ != COVER_OPERATION_CLOSING) {
-        // Different direction from previous - single pulse
-        ESP_LOGD(TAG, "Partial position, direction change - sending single pulse");
-        send_pulse = true;
-      } else {
-        // Same direction as before - double pulse
-        ESP_LOGD(TAG, "Partial position, same direction - sending double pulse");
-        send_double_pulse = true;
+      planned = this->plan_pulses_(goal, plan, output);
+      if (!planned) {
+        // Nothing stops this controller between the ends: the gate runs on to the end ahead
+        ESP_LOGW(TAG, "Controller cannot stop mid-travel, running to the end");
+        this->target_position_ = this->current_operation == COVER_OPERATION_OPENING ? MOTION_ONE : 0;
+        this->command_pending_ = false;
+        this->publish_trajectory_();
+        if (this->motion_mode_ == MOTION_MODE_EVENT) {
+          this->arm_target_timer_();
+        }
+        return;
       }
     }
+  } else if (dir == COVER_OPERATION_OPENING ? this->position >= COVER_OPEN : this->position <= COVER_CLOSED) {
+    ESP_LOGV(TAG, "Already at the end - no pulse needed");
+  } else {
+    planned = this->plan_pulses_(goal, plan, output);
   }
-
-  // Execute the appropriate pulse sequence
-  ESP_LOGV(TAG, "Pulse decision: send_pulse=%s, send_double_pulse=%s", 
-           send_pulse ? "true" : "false", send_double_pulse ? "true" : "false");
+  if (planned && dir != COVER_OPERATION_IDLE && plan.starts > this->starts_left_()) {
+    // Even the best plan runs out of cycles on the way: trip before its first press
+    // rather than stop the gate part way, possibly heading the wrong way
+    ESP_LOGW(TAG, "Reaching %.2f takes %u start(s), %u left before the safety trip",
+             from_motion(this->target_position_), plan.starts, this->starts_left_());
+    this->command_pending_ = false;
+    this->trip_cycle_safety_(this->safety_cycle_count_ + plan.starts);
+    return;
+  }
+  // Some press, planned now or left in the running pattern, is still to reach the goal
+  const bool pressing = planned && (plan.presses > 0 || plan.lead > 0);
   
-  if (send_double_pulse) {
-    this->send_double_pulse_();
-    this->safety_cycle_count_ += 2;  // Double pulse counts as 2 cycles
-  } else if (send_pulse) {
-    this->send_pulse_();
-    this->safety_cycle_count_++;
+  // Time this command until the relay closes, unless it needs no pulse
+  this->latency_pending_ = this->command_pending_ && pressing;
+  this->command_pending_ = false;
+  
+  if (pressing) {
+    // The plan takes effect with the press that reaches its goal, see on_press_()
+    this->lead_in_ = true;
+    this->lead_in_goal_ = goal;
+    this->lead_in_position_ = to_motion(this->position);
+    this->lead_in_time_ = millis();
+    this->send_plan_(plan, output);
+    this->safety_cycle_count_ += plan.starts;  // Each start or reversal of the gate is a cycle
+  }
+  const bool send_pulse = plan.presses == 1;
+  
+  if (dir == COVER_OPERATION_IDLE && pressing) {
+    if (this->lead_in_) {
+      // The gate runs on until the press that stops it, which puts it to rest
+      this->lead_stop_dir_ = COVER_OPERATION_IDLE;
+    } else {
+      // The gate keeps moving for the stop lead after the pulse; it comes to rest there
+      const CoverOperation stopped = this->current_operation;
+      this->lead_rest_position_ = this->position_at_(millis() + static_cast<uint32_t>(this->stop_lead_(stopped)));
+      this->position = from_motion(this->lead_rest_position_);
+      this->lead_stop_dir_ = this->learn_stop_lead_ && this->pulse_sent_ ? stopped : COVER_OPERATION_IDLE;
+    }
+    this->run_dir_ = COVER_OPERATION_IDLE;
+  } else if (dir != COVER_OPERATION_IDLE && pressing) {
+    // Only a single pulse sent right away times the run well enough
+    const bool first_run = this->run_dir_ == COVER_OPERATION_IDLE;
+    if (send_pulse && this->pulse_sent_) {
+      this->run_dir_ = dir;
+      this->run_start_ = millis();
+#ifdef USE_BINARY_SENSOR
+      this->run_from_endstop_ = this->at_endstop_(dir == COVER_OPERATION_CLOSING);
+#endif
+    } else {
+      this->run_dir_ = COVER_OPERATION_IDLE;
+    }
+    // The stop lead is checked by the first run after the stop, started from its rest position
+    if (!first_run || this->run_dir_ == COVER_OPERATION_IDLE || to_motion(this->position) != this->lead_rest_position_) {
+      this->lead_stop_dir_ = COVER_OPERATION_IDLE;
+    }
   }
 
   // Update operation state
@@ -271,332 +614,1127 @@ void ImpulseCover::start_direction_(cover::CoverOperation dir) {
   if (dir != COVER_OPERATION_IDLE) {
     ESP_LOGI(TAG, "Starting %s operation to %.2f (cycle %u/%u)", 
              dir == COVER_OPERATION_OPENING ? "OPEN" : "CLOSE",
-             this->target_position_,
+             from_motion(this->target_position_),
              this->safety_cycle_count_, this->safety_max_cycles_);
              
     // Fire appropriate triggers
     if (dir == COVER_OPERATION_OPENING) {
-      this->fire_on_open_triggers_();
+      this->fire_triggers_(TRIGGER_OPEN);
     } else if (dir == COVER_OPERATION_CLOSING) {
-      this->fire_on_close_triggers_();
+      this->fire_triggers_(TRIGGER_CLOSE);
     }
   } else {
     ESP_LOGI(TAG, "Stopping movement");
-    this->fire_on_idle_triggers_();
+    this->fire_triggers_(TRIGGER_IDLE);
   }
 }
 
 void ImpulseCover::set_current_operation_(cover::CoverOperation operation, bool is_triggered) {
+  const CoverOperation previous = this->current_operation;
   if (is_triggered) {
     this->current_trigger_operation_ = operation;
   }
   
-  auto now = millis();
   this->current_operation = operation;
-  this->start_dir_time_ = this->last_recompute_time_ = now;
   this->pulse_sent_ = false;
+  if (!is_triggered && operation == COVER_OPERATION_IDLE) {
+    // Ended by the gate itself: no press still on its way changes that
+    this->lead_in_ = false;
+  }
+  this->anchor_move_(operation);
+  if (operation == COVER_OPERATION_IDLE && !this->ack_stop_) {
+    // Nothing left to start; a stop press stays checked
+    this->cancel_ack_();
+  }
+  if (operation == COVER_OPERATION_IDLE && this->is_intermediate_target_()) {
+    // A stop short of the endstop cancels its predicted arrival
+    this->predicted_dir_ = COVER_OPERATION_IDLE;
+  }
   
   if (operation != COVER_OPERATION_IDLE) {
     this->last_operation_ = operation;
   }
+  this->trace_(TRACE_OPERATION, operation, EventTrace::encode_position(this->position));
   
-  this->publish_state();
-  this->last_publish_time_ = now;
+  this->publish_state_(PUBLISH_TRANSITION);
+  this->publish_trajectory_();
+  this->request_save_();
+  if (operation == COVER_OPERATION_IDLE) {
+    this->publish_diagnostics_();
+  }
+  
+  if (this->hub_ != nullptr && (is_triggered || operation != previous)) {
+    // Presses sent or the gate seen to change: the hub counts each (re)start
+    this->hub_->set_moving(this, operation != COVER_OPERATION_IDLE);
+  }
+  if (this->motion_mode_ == MOTION_MODE_EVENT) {
+    if (operation != COVER_OPERATION_IDLE && this->current_trigger_operation_ != COVER_OPERATION_IDLE) {
+      this->arm_motion_timers_();
+    } else {
+      this->cancel_motion_timers_();
+    }
+  }
 }
 
-void ImpulseCover::recompute_position_() {
-  if (this->current_operation == COVER_OPERATION_IDLE)
-    return;
-
+void ImpulseCover::anchor_move_(cover::CoverOperation operation) {
   const uint32_t now = millis();
-  const uint32_t elapsed = now - this->last_recompute_time_;
-  
-  float dir;
-  float action_dur;
-  
-  switch (this->current_operation) {
-    case COVER_OPERATION_OPENING:
-      dir = 1.0f;
-      action_dur = this->open_duration_;
-      break;
-    case COVER_OPERATION_CLOSING:
-      dir = -1.0f;
-      action_dur = this->close_duration_;
-      break;
-    default:
-      return;
+  this->start_dir_time_ = now;
+  this->anchor_time_ = now;
+  this->start_position_ = this->position;
+  if (operation == COVER_OPERATION_IDLE) {
+    return;
   }
   
-  // Calculate position based on time - using captured start position
-  float progress = std::min(1.0f, static_cast<float>(elapsed) / action_dur);
-  this->position = (this->current_operation == COVER_OPERATION_OPENING) ?
-                   (this->position + progress) : (this->position - progress);
-  
+  // Locate the start position on the direction's curve so the move can be
+  // evaluated in closed form from (anchor_time_, start_offset_); held during a lead-in
+  this->start_offset_ = this->curve_time_(operation, to_motion(this->position));
+  this->move_duration_ = operation == COVER_OPERATION_OPENING ? this->open_duration_ : this->close_duration_;
+  this->motion_rate_ = this->lead_in_ ? 0 : motion_rate(this->move_duration_);
+  this->feedback_.start_move();
   
-  // Clamp position
-  if (this->position < COVER_CLOSED) this->position = COVER_CLOSED;
-  if (this->position > COVER_OPEN) this->position = COVER_OPEN;
-  
-  this->last_recompute_time_ = now;
+  // When the endstop ahead should be reached
+  const motion_t endstop = operation == COVER_OPERATION_OPENING ? MOTION_ONE : 0;
+  this->predicted_arrival_ = now + this->time_to_position_(endstop);
+  this->predicted_dir_ = operation;
 }
 
-bool ImpulseCover::is_at_target_() const {
-  const float tolerance = 0.00f;  // 1% tolerance
-  
-  switch (this->current_trigger_operation_) {
-    case COVER_OPERATION_OPENING:
-      return this->position >= this->target_position_ - tolerance;
-    case COVER_OPERATION_CLOSING:
-      return this->position <= this->target_position_ + tolerance;
-    case COVER_OPERATION_IDLE:
-      return this->current_operation == COVER_OPERATION_IDLE;
-    default:
-      return true;
-  }
+motion_t ImpulseCover::lead_in_position_at_(uint32_t now) const {
+  return this->travel_from_(this->controller_.get_state(), this->lead_in_position_, now - this->lead_in_time_);
 }
 
-// Private helper methods
-void ImpulseCover::send_pulse_() {
-  this->send_pulse_internal_(false);
+motion_t ImpulseCover::travel_from_(ControllerState state, motion_t from, uint32_t elapsed) const {
+  // Constant speed in whichever direction the controller state has the gate moving
+  if (state != CONTROLLER_OPENING && state != CONTROLLER_CLOSING) {
+    return from;
+  }
+  const bool opening = state == CONTROLLER_OPENING;
+  const motion_t travel = motion_travel(elapsed, motion_rate(opening ? this->open_duration_ : this->close_duration_));
+  if (opening) {
+    return travel < MOTION_ONE - from ? from + travel : MOTION_ONE;
+  }
+  return travel < from ? from - travel : 0;
 }
 
-void ImpulseCover::send_double_pulse_() {
-  this->send_pulse_internal_(true);
+void ImpulseCover::end_lead_in_() {
+  // A new command during a lead-in: the plan so far is re-based on where the gate got to
+  this->position = from_motion(this->lead_in_position_at_(millis()));
+  this->lead_in_ = false;
+  if (this->current_operation != COVER_OPERATION_IDLE) {
+    this->anchor_move_(this->current_operation);
+  }
 }
 
-void ImpulseCover::send_pulse_internal_(bool double_pulse) {
-  ESP_LOGV(TAG, "send_pulse_internal_ called with double_pulse=%s", double_pulse ? "true" : "false");
-  
-  if (this->output_ == nullptr) {
-    ESP_LOGE(TAG, "Output is null! Cannot send pulse");
-    return;
-  }
-  
-  if (this->pulse_sent_) {
-    ESP_LOGV(TAG, "Pulse already sent, skipping");
-    return;
-  }
-  
+void ImpulseCover::on_press_() {
+  // Every press the controller sees moves its tracked state one step
   const uint32_t now = millis();
-  ESP_LOGV(TAG, "Current time: %u, last_pulse_time_: %u, pulse_delay_: %u", 
-           now, this->last_pulse_time_, this->pulse_delay_);
-  
-  // Check if enough time has passed since last pulse
-  if ((now - this->last_pulse_time_) < this->pulse_delay_) {
-    const char* pulse_type = double_pulse ? "double" : "single";
-    ESP_LOGV(TAG, "Pulse too rapid, delaying %s pulse", pulse_type);
-    
-    std::string timeout_name = double_pulse ? "double_pulse_delay" : "single_pulse_delay";
-    this->set_timeout(timeout_name, this->pulse_delay_ - (now - this->last_pulse_time_), [this, double_pulse]() {
-      this->send_pulse_internal_(double_pulse);
-    });
-    return;
+  if (this->lead_in_) {
+    this->lead_in_position_ = this->lead_in_position_at_(now);
+    this->lead_in_time_ = now;
+    // A run of the plan that reached an end stopped there, as the planner has it
+    const ControllerState state = this->controller_.get_state();
+    if ((state == CONTROLLER_OPENING && this->lead_in_position_ == MOTION_ONE) ||
+        (state == CONTROLLER_CLOSING && this->lead_in_position_ == 0)) {
+      this->controller_.at_end(state == CONTROLLER_OPENING);
+    }
   }
-  
-  if (double_pulse) {
-    ESP_LOGD(TAG, "Sending double control pulse");
-    
-    // First pulse
-    ESP_LOGV(TAG, "Turning output ON (first pulse)");
-    this->output_->turn_on();
-    this->set_timeout("double_pulse_first_off", this->pulse_delay_ , [this]() { 
-      ESP_LOGV(TAG, "Turning output OFF (after first pulse)");
-      this->output_->turn_off();
-      // Second pulse after a short delay
-      this->set_timeout("double_pulse_second_on", 2 * this->pulse_delay_ , [this]() {
-        ESP_LOGV(TAG, "Turning output ON (second pulse)");
-        this->output_->turn_on();
-        this->set_timeout("double_pulse_second_off", this->pulse_delay_ , [this]() { 
-          ESP_LOGV(TAG, "Turning output OFF (after second pulse)");
-          this->output_->turn_off(); 
-        });
-      });
-    });
-  } else {
-    ESP_LOGD(TAG, "Sending single control pulse");
-    
-    ESP_LOGV(TAG, "Turning output ON");
-    this->output_->turn_on();
-    ESP_LOGV(TAG, "Setting timeout for output OFF in %ums", this->pulse_delay_);
-    this->set_timeout("single_pulse_off", this->pulse_delay_, [this]() {
-      ESP_LOGV(TAG, "Turning output OFF");
-      this->output_->turn_off(); 
-    });
+  const ControllerState before = this->controller_.get_state();
+  switch (this->running_output_) {
+    case PULSE_OUTPUT_OPEN:
+      this->controller_.command(CONTROLLER_GOAL_OPEN);
+      break;
+    case PULSE_OUTPUT_CLOSE:
+      this->controller_.command(CONTROLLER_GOAL_CLOSE);
+      break;
+    case PULSE_OUTPUT_STOP:
+      this->controller_.command(CONTROLLER_GOAL_STOP);
+      break;
+    default:
+      this->controller_.press();
+      break;
   }
-  
-  this->last_pulse_time_ = millis();
-  this->pulse_sent_ = true;
-  ESP_LOGV(TAG, "Pulse sequence initiated, pulse_sent_ set to true");
-}
-
-void ImpulseCover::check_safety_() {
-  if (this->current_operation == COVER_OPERATION_IDLE) {
+  const ControllerState after = this->controller_.get_state();
+  if (this->hub_ != nullptr && this->current_operation != COVER_OPERATION_IDLE && after != before &&
+      !ControllerFsm::reaches(after, CONTROLLER_GOAL_STOP)) {
+    // This press (re)starts the motor: a reversal's goes out after its stop press
+    this->hub_->on_motor_start(this);
+  }
+  if (!this->lead_in_ || !ControllerFsm::reaches(after, this->lead_in_goal_)) {
     return;
   }
-  
-  // Check cycle count safety
-  if (this->safety_cycle_count_ >= this->safety_max_cycles_) {
-    ESP_LOGW(TAG, "Safety max cycles triggered (%u cycles)", this->safety_cycle_count_);
-    this->safety_triggered_ = true;
-    this->fire_on_safety_triggers_();
-    this->start_direction_(COVER_OPERATION_IDLE);
+  // The press that reaches the goal: the plan takes effect here. Sent from
+  // start_direction_() itself, that takes it from there.
+  this->lead_in_ = false;
+  this->expect_ack_(before, now);
+  if (this->lead_in_goal_ == CONTROLLER_GOAL_STOP) {
+    if (this->current_operation != COVER_OPERATION_IDLE) {
+      return;
+    }
+    // The gate coasts on for the stop lead of the direction it was going
+    const uint32_t lead = static_cast<uint32_t>(
+        this->stop_lead_(before == CONTROLLER_OPENING ? COVER_OPERATION_OPENING : COVER_OPERATION_CLOSING));
+    this->lead_rest_position_ = this->travel_from_(before, this->lead_in_position_, lead);
+    this->position = from_motion(this->lead_rest_position_);
+    this->publish_state_(PUBLISH_TRANSITION);
+    this->publish_trajectory_();
+    this->request_save_();
     return;
   }
-  
-  // Auto-reset safety cycle count after period of inactivity
-  const uint32_t now = millis();
-  if (this->current_operation == COVER_OPERATION_IDLE && 
-      this->safety_cycle_count_ > 0 && 
-      (now - this->start_dir_time_) > 30000) {
-    ESP_LOGV(TAG, "Auto-resetting safety cycle count after inactivity");
-    this->safety_cycle_count_ = 0;
+  const CoverOperation dir =
+      this->lead_in_goal_ == CONTROLLER_GOAL_OPEN ? COVER_OPERATION_OPENING : COVER_OPERATION_CLOSING;
+  this->position = from_motion(this->lead_in_position_);
+  if (this->current_operation == dir) {
+    this->anchor_move_(dir);
+    this->publish_trajectory_();
+    if (this->motion_mode_ == MOTION_MODE_EVENT && this->current_trigger_operation_ != COVER_OPERATION_IDLE) {
+      this->arm_target_timer_();
+    }
   }
 }
 
-#ifdef USE_BINARY_SENSOR
-void ImpulseCover::update_position_from_sensors_(bool is_initialization) {
-  bool has_open_sensor = (this->open_sensor_ != nullptr);
-  bool has_close_sensor = (this->close_sensor_ != nullptr);
-  bool open_sensor_active = has_open_sensor && this->get_sensor_state_(this->open_sensor_, this->open_sensor_inverted_);
-  bool close_sensor_active = has_close_sensor && this->get_sensor_state_(this->close_sensor_, this->close_sensor_inverted_);
-  
-  ESP_LOGV(TAG, "Sensors: open=%s (active=%s), close=%s (active=%s)", 
-           has_open_sensor ? "YES" : "NO", open_sensor_active ? "YES" : "NO",
-           has_close_sensor ? "YES" : "NO", close_sensor_active ? "YES" : "NO");
-  
-  float old_position = this->position;
-  bool position_updated = false;
-  
-  if (has_open_sensor && has_close_sensor) {
-    // Both sensors configured - use precise logic
-    if (open_sensor_active && !close_sensor_active) {
-      if (is_initialization || this->position != COVER_OPEN) {
-        this->position = COVER_OPEN;
-        position_updated = true;
-        if (is_initialization) {
-          this->has_initial_state_ = true;
-          ESP_LOGI(TAG, "Initial state: OPEN (open sensor active, close sensor inactive)");
-        } else {
-          ESP_LOGW(TAG, "Position misalignment detected: position=%.3f but open sensor active - correcting to OPEN", old_position);
-        }
-      }
-    } else if (close_sensor_active && !open_sensor_active) {
-      if (is_initialization || this->position != COVER_CLOSED) {
-        this->position = COVER_CLOSED;
-        position_updated = true;
-        if (is_initialization) {
-          this->has_initial_state_ = true;
-          ESP_LOGI(TAG, "Initial state: CLOSED (close sensor active, open sensor inactive)");
-        } else {
-          ESP_LOGW(TAG, "Position misalignment detected: position=%.3f but close sensor active - correcting to CLOSED", old_position);
-        }
-      }
-    } else if (!open_sensor_active && !close_sensor_active) {
-      if (is_initialization) {
-        this->position = 0.5f;  // Unknown position - intermediate
-        this->has_initial_state_ = false;
-        ESP_LOGD(TAG, "Initial state: UNKNOWN (neither sensor active) - position set to 50%%");
-      } else if (this->position == COVER_OPEN || this->position == COVER_CLOSED) {
-        // Position indicates endpoint but no sensor active - misalignment
-        ESP_LOGW(TAG, "Position misalignment detected: position=%s but no sensor active - correcting to intermediate", 
-                 this->position == COVER_OPEN ? "OPEN" : "CLOSED");
-        this->position = 0.5f;
-        position_updated = true;
-      }
-    } else {
-      // Both sensors active - should not happen, probably misconfiguration
-      if (is_initialization) {
-        ESP_LOGW(TAG, "Both sensors active simultaneously - possible misconfiguration!");
-        this->position = 0.5f;  // Unknown position
-        this->has_initial_state_ = false;
-        ESP_LOGD(TAG, "Initial state: CONFLICT (both sensors active) - position set to 50%%");
-      } else {
-        ESP_LOGW(TAG, "Sensor conflict detected: both sensors active simultaneously!");
-      }
+void ImpulseCover::fix_position_(motion_t position) {
+  // A measured position: the estimate is re-anchored on it, and the fixes of a move time
+  // its speed. Only a fix that moves the estimate by FIX_CORRECTION or more is a correction.
+  this->recompute_position_();
+  const motion_t estimate = to_motion(this->position);
+  const motion_t error = position > estimate ? position - estimate : estimate - position;
+  const uint32_t now = millis();
+  this->position = from_motion(position);
+  if (this->lead_in_) {
+    // The presses still to come move the gate on from here
+    this->lead_in_position_ = position;
+    this->lead_in_time_ = now;
+  } else if (this->current_operation != COVER_OPERATION_IDLE) {
+    const CoverOperation dir = this->current_operation;
+    const motion_t curve_time = this->curve_time_(dir, position);
+    const uint32_t duration = this->feedback_.fix(now, curve_time);
+    if (duration != 0) {
+      // Bounded like learned durations
+      const float nominal = dir == COVER_OPERATION_OPENING ? this->open_duration_ : this->close_duration_;
+      this->move_duration_ = static_cast<uint32_t>(
+          std::min(std::max(float(duration), nominal * (1.0f - DURATION_BOUND)), nominal * (1.0f + DURATION_BOUND)));
+      this->motion_rate_ = motion_rate(this->move_duration_);
     }
-  } else if (has_open_sensor && !has_close_sensor) {
-    // Only open sensor configured
-    if (open_sensor_active) {
-      if (is_initialization || this->position != COVER_OPEN) {
-        this->position = COVER_OPEN;
-        position_updated = true;
-        if (is_initialization) {
-          this->has_initial_state_ = true;
-          ESP_LOGI(TAG, "Initial state: OPEN (open sensor active)");
-        } else {
-          ESP_LOGW(TAG, "Position misalignment detected: position=%.3f but open sensor active - correcting to OPEN", old_position);
-        }
-      }
-    } else {
-      if (is_initialization) {
-        this->position = COVER_CLOSED;  // Default to closed when open sensor inactive
-        this->has_initial_state_ = false;
-        ESP_LOGD(TAG, "Initial state: CLOSED (open sensor inactive, assuming closed)");
-      } else if (this->position == COVER_OPEN) {
-        // Position indicates open but open sensor inactive - misalignment
-        ESP_LOGW(TAG, "Position misalignment detected: position=OPEN but open sensor inactive - correcting to CLOSED");
-        this->position = COVER_CLOSED;
-        position_updated = true;
-      }
+    this->anchor_time_ = now;
+    this->start_offset_ = curve_time;
+    if (this->predicted_dir_ == dir) {
+      this->predicted_arrival_ = now + this->time_to_position_(dir == COVER_OPERATION_OPENING ? MOTION_ONE : 0);
     }
-  } else if (!has_open_sensor && has_close_sensor) {
-    // Only close sensor configured
-    if (close_sensor_active) {
-      if (is_initialization || this->position != COVER_CLOSED) {
-        this->position = COVER_CLOSED;
-        position_updated = true;
-        if (is_initialization) {
-          this->has_initial_state_ = true;
-          ESP_LOGI(TAG, "Initial state: CLOSED (close sensor active)");
-        } else {
-          ESP_LOGW(TAG, "Position misalignment detected: position=%.3f but close sensor active - correcting to CLOSED", old_position);
-        }
-      }
-    } else {
-      if (is_initialization) {
-        this->position = COVER_OPEN;  // Default to open when close sensor inactive
-        this->has_initial_state_ = false;
-        ESP_LOGD(TAG, "Initial state: OPEN (close sensor inactive, assuming open)");
-      } else if (this->position == COVER_CLOSED) {
-        // Position indicates closed but close sensor inactive - misalignment
-        ESP_LOGW(TAG, "Position misalignment detected: position=CLOSED but close sensor inactive - correcting to OPEN");
-        this->position = COVER_OPEN;
-        position_updated = true;
-      }
+    if (this->motion_mode_ == MOTION_MODE_EVENT && this->current_trigger_operation_ != COVER_OPERATION_IDLE) {
+      this->arm_target_timer_();
     }
-  } else if (is_initialization) {
-    // No sensors configured - keep restore state or default
-    ESP_LOGV(TAG, "No sensors configured - keeping current position: %.2f", this->position);
   }
-  
-  if (!is_initialization) {
-    if (position_updated) {
-      ESP_LOGI(TAG, "Position corrected based on sensor feedback");
-      this->publish_state();
-    } else {
-      ESP_LOGV(TAG, "Sensor alignment check passed - no correction needed");
-    }
+  if (error < to_motion(FIX_CORRECTION)) {
+    return;
   }
+  ESP_LOGD(TAG, "Position fixed at %.3f, estimate was %.3f", from_motion(position), from_motion(estimate));
+  this->trace_(TRACE_CORRECTION, 0, EventTrace::encode_position(this->position));
+  this->stats_.corrections++;
+  this->publish_state_(PUBLISH_TRANSITION);
+  this->publish_trajectory_();
+  this->request_save_();
 }
 
-void ImpulseCover::check_sensor_alignment_() {
-  ESP_LOGV(TAG, "Checking sensor alignment with current position...");
-  ESP_LOGV(TAG, "Current position: %.3f", this->position);
-  this->update_position_from_sensors_(false);
+int8_t ImpulseCover::travel_direction_() const {
+  // Which way the gate moves, for encoder counts, from the presses the controller got: a
+  // stopped controller still coasts the gate the way it last moved
+  switch (this->controller_.get_state()) {
+    case CONTROLLER_OPENING:
+    case CONTROLLER_STOPPED_NEXT_CLOSE:
+      return 1;
+    case CONTROLLER_CLOSING:
+    case CONTROLLER_STOPPED_NEXT_OPEN:
+      return -1;
+    default:
+      return 0;
+  }
 }
 
-void ImpulseCover::endstop_reached_(bool open_endstop) {
+void ImpulseCover::publish_state_(PublishReason reason) {
+  // Every state publish of the cover goes through here
   const uint32_t now = millis();
+  if (reason == PUBLISH_PROGRESS) {
+    if (this->publish_transitions_only_ || this->current_operation == COVER_OPERATION_IDLE)
+      return;
+    if (now - this->last_publish_time_ < this->publish_min_interval_)
+      return;
+    if (std::fabs(this->position - this->last_published_position_) < this->publish_min_delta_)
+      return;
+  } else if (reason == PUBLISH_HEARTBEAT) {
+    if (now - this->last_publish_time_ < this->publish_heartbeat_)
+      return;
+  }
   
-  ESP_LOGV(TAG, "endstop_reached_ called - open_endstop=%s", open_endstop ? "true" : "false");
-  ESP_LOGV(TAG, "Current state: position=%.3f, current_operation=%d, current_trigger_operation_=%d", 
-           this->position, static_cast<int>(this->current_operation), static_cast<int>(this->current_trigger_operation_));
-  ESP_LOGV(TAG, "Expected operation for this endstop: %d", 
+  this->publish_state(false);
+  this->last_publish_time_ = now;
+  this->last_published_position_ = this->position;
+}
+
+void ImpulseCover::publish_trajectory_() {
+  // Once per transition, enough for clients to interpolate the move themselves
+  const bool moving = this->current_operation != COVER_OPERATION_IDLE;
+  const float target = moving ? from_motion(this->target_position_) : this->position;
+  const uint32_t now = millis();
+  const uint32_t elapsed = now - this->anchor_time_;
+  const uint32_t to_target = moving ? this->time_to_position_(this->target_position_) : 0;
+  const uint32_t eta = to_target > elapsed ? to_target - elapsed : 0;
+#ifdef USE_SENSOR
+  if (this->eta_sensor_ != nullptr) {
+    this->eta_sensor_->publish_state(eta / 1e3f);
+  }
+  if (this->target_sensor_ != nullptr) {
+    this->target_sensor_->publish_state(target * 100.0f);
+  }
+#endif
+#if defined(USE_TEXT_SENSOR) && !defined(IMPULSE_COVER_ZERO_HEAP)
+  // TextSensor keeps its value in std::strings, so every publish allocates; zero_heap
+  // configs cannot have this sensor (text_sensor.py)
+  if (this->trajectory_text_sensor_ == nullptr)
+    return;
+
+  // {"op":..,"from":..,"to":..,"start":uptime ms of "from","eta":ms[,"duration":full run ms,"curve":[..]]}
+  char buf[192];
+  const bool opening = this->current_operation == COVER_OPERATION_OPENING;
+  int len = snprintf(buf, sizeof(buf), "{\"op\":\"%s\",\"from\":%.3f,\"to\":%.3f,\"start\":%u,\"eta\":%u",
+                     moving ? (opening ? "opening" : "closing") : "idle", this->position, target,
+                     now, eta);
+  if (moving) {
+    len += snprintf(buf + len, sizeof(buf) - len, ",\"duration\":%u", this->move_duration_);
+    const TravelCurve *curve = opening ? this->open_curve_ : this->close_curve_;
+    if (curve != nullptr) {
+      // Progress at each eighth of a full run
+      len += snprintf(buf + len, sizeof(buf) - len, ",\"curve\":[");
+      for (uint8_t i = 0; i <= 8; i++) {
+        len += snprintf(buf + len, sizeof(buf) - len, i == 0 ? "%.2f" : ",%.2f", curve->progress_at(i / 8.0f));
+      }
+      len += snprintf(buf + len, sizeof(buf) - len, "]");
+    }
+  }
+  snprintf(buf + len, sizeof(buf) - len, "}");
+  this->trajectory_text_sensor_->publish_state(buf);
+#endif
+}
+
+void ImpulseCover::on_target_reached_() {
+  ESP_LOGI(TAG, "Target position reached, stopping movement");
+  this->trace_(TRACE_TARGET, 0, EventTrace::encode_position(this->position));
+  
+  // In impulse mode, only send stop pulse for intermediate positions
+  // Final positions (fully open/closed) will stop automatically at endstops
+  if (this->is_intermediate_target_()) {
+    ESP_LOGD(TAG, "Intermediate target - sending stop pulse");
+    this->start_direction_(COVER_OPERATION_IDLE);
+  } else {
+    ESP_LOGV(TAG, "Final position target - no stop pulse needed");
+    this->controller_.at_end(this->current_operation == COVER_OPERATION_OPENING);
+    this->set_current_operation_(COVER_OPERATION_IDLE, false);
+  }
+}
+
+void ImpulseCover::on_safety_timeout_() {
+  ESP_LOGW(TAG, "Safety timeout reached, stopping movement");
+  this->trace_(TRACE_SAFETY, TRACE_SAFETY_TIMEOUT, this->safety_cycle_count_);
+  this->stats_.safety_trips++;
+  // Whatever the gate did, the controller has long stopped itself at the end ahead
+  this->controller_.at_end(this->current_operation == COVER_OPERATION_OPENING);
+  this->set_current_operation_(COVER_OPERATION_IDLE, false);
+}
+
+void ImpulseCover::on_current_(float current) {
+  const CurrentEvent event = this->current_monitor_.update(current, millis());
+  if (event == CURRENT_NONE) {
+    return;
+  }
+  this->trace_(TRACE_CURRENT, event, static_cast<uint16_t>(std::min(std::max(current, 0.0f) * 100.0f, 65535.0f)));
+  switch (event) {
+    case CURRENT_START:
+      ESP_LOGD(TAG, "Motor started");
+      this->on_ack_(true, this->current_monitor_.get_edge_time());
+      break;
+    case CURRENT_STOP:
+      this->on_ack_(false, this->current_monitor_.get_edge_time());
+      this->on_motor_stopped_(this->current_monitor_.get_edge_time());
+      break;
+    case CURRENT_STALL:
+      this->on_stall_();
+      break;
+    default:
+      break;
+  }
+}
+
+void ImpulseCover::on_motor_stopped_(uint32_t stopped_at) {
+  // Only a stop the cover did not ask for: its own stop press has already put it idle,
+  // and presses still on their way stop the motor on purpose
+  if (this->current_operation == COVER_OPERATION_IDLE || this->lead_in_ || this->pulse_sequencer_.is_running() ||
+      static_cast<int32_t>(stopped_at - this->start_dir_time_) < 0) {
+    ESP_LOGD(TAG, "Motor stopped");
+    return;
+  }
+  this->recompute_position_();
+  const bool opening = this->current_operation == COVER_OPERATION_OPENING;
+  const motion_t position = this->position_at_(stopped_at);
+  bool end_sensor = false;
+#ifdef USE_BINARY_SENSOR
+  end_sensor = (opening ? this->open_sensor_ : this->close_sensor_) != nullptr;
+#endif
+  if (!end_sensor) {
+    // The controller's own limit, if the run can be there: the estimate may be off by some
+    // drift, or unknown since boot, but a gate does not reach an end a few seconds into a run
+    const motion_t to_end = opening ? MOTION_ONE - position : position;
+    const float duration = opening ? this->open_duration_ : this->close_duration_;
+    if (to_end <= to_motion(MOTOR_STOP_END_BAND) ||
+        float(stopped_at - this->start_dir_time_) >= MOTOR_STOP_END_RUN * duration) {
+      ESP_LOGD(TAG, "Motor stopped at %.3f, taken as the %s end", from_motion(position), opening ? "open" : "close");
+      this->arrive_at_end_(opening, stopped_at);
+      return;
+    }
+  }
+  // The endstop there, or the run so far, rules out the end: something else stopped the gate
+  ESP_LOGW(TAG, "Motor stopped at %.3f short of the %s end", from_motion(position), opening ? "open" : "close");
+  this->position = from_motion(position);
+  this->controller_.command(CONTROLLER_GOAL_STOP);
+  this->set_current_operation_(COVER_OPERATION_IDLE, false);
+}
+
+void ImpulseCover::on_stall_() {
+  if (this->current_operation == COVER_OPERATION_IDLE && !this->lead_in_) {
+    ESP_LOGW(TAG, "Motor stalled while idle");
+    return;
+  }
+  ESP_LOGW(TAG, "Motor stalled, stopping movement");
+  this->trace_(TRACE_SAFETY, TRACE_SAFETY_STALL, this->safety_cycle_count_);
+  this->stats_.safety_trips++;
+  // Stop before the safety flag makes start_direction_() refuse, as check_safety_() does
+  this->start_direction_(COVER_OPERATION_IDLE);
+  this->safety_triggered_ = true;
+  this->fire_triggers_(TRIGGER_SAFETY);
+}
+
+bool ImpulseCover::awaits_motor_stop_() const {
+  // A run to an end lasts until the motor stops there, however long the estimate says it takes
+  return this->current_monitor_.is_running() && !this->is_intermediate_target_() &&
+         this->current_operation != COVER_OPERATION_IDLE &&
+         this->current_operation == this->current_trigger_operation_;
+}
+
+void ImpulseCover::expect_ack_(ControllerState before, uint32_t now) {
+  // A press that starts the gate from rest, or stops it, with something to see that by;
+  // reversals of a moving gate are not checked
+  const bool stop = this->lead_in_goal_ == CONTROLLER_GOAL_STOP;
+  if (this->ack_timeout_ == 0 || stop == ControllerFsm::reaches(before, CONTROLLER_GOAL_STOP) ||
+      !this->can_ack_(stop)) {
+    return;
+  }
+  this->ack_pending_ = true;
+  this->ack_stop_ = stop;
+  this->ack_press_time_ = now;
+  this->ack_state_ = before;
+  this->ack_position_ = this->lead_in_position_;
+  this->arm_timer_(TIMER_PULSE_ACK, this->ack_timeout_);
+}
+
+bool ImpulseCover::can_ack_(bool stop) const {
+#ifdef USE_SENSOR
+  // The current shows the edge the press asks for only from the other level: a stop once it
+  // saw the motor run, a start once it saw it stop. After a plan's earlier presses the stop
+  // may still be debouncing, and the start would never show.
+  if (this->current_sensor_ != nullptr && stop == this->current_monitor_.is_running()) {
+    return true;
+  }
+  if (!stop && this->encoder_sensor_ != nullptr) {
+    return true;
+  }
+#endif
+#ifdef USE_BINARY_SENSOR
+  // Leaving an end: its endstop releases. Only the motor current tells a stop.
+  return !stop && (this->endstop_active_(true) || this->endstop_active_(false));
+#else
+  return false;
+#endif
+}
+
+void ImpulseCover::on_ack_(bool moving, uint32_t seen_at) {
+  // The gate shows it moves, or that its motor stopped: an acknowledgement if the press asked for that
+  if (!this->ack_pending_ || moving == this->ack_stop_) {
+    return;
+  }
+  this->cancel_ack_();
+  const int32_t latency = static_cast<int32_t>(seen_at - this->ack_press_time_);
+  this->stats_.ack_latency.add(latency > 0 ? latency : 0);
+  this->trace_(TRACE_ACK, TRACE_ACK_SEEN, static_cast<uint16_t>(std::min(std::max(latency, 0), 65535)));
+  ESP_LOGV(TAG, "Gate %s %dms after the press", moving ? "moving" : "stopped", latency);
+  if (moving && this->motion_mode_ == MOTION_MODE_EVENT && this->current_operation != COVER_OPERATION_IDLE &&
+      this->current_trigger_operation_ == this->current_operation) {
+    // A target that fell due meanwhile is handled now
+    this->arm_target_timer_();
+  }
+}
+
+void ImpulseCover::on_ack_timeout_() {
+  this->ack_pending_ = false;
+#ifdef USE_SENSOR
+  if (this->current_sensor_ != nullptr && this->current_monitor_.is_running() != this->ack_stop_) {
+    // No edge came, but the motor is where the press asked: nothing to rewind or send again
+    ESP_LOGD(TAG, "Motor %s, taking the press as seen", this->ack_stop_ ? "stopped" : "running");
+    return;
+  }
+#endif
+  this->stats_.missed_presses++;
+  this->trace_(TRACE_ACK, TRACE_ACK_MISSED, this->ack_attempts_);
+  // The controller never saw the press: it is still in its state before it
+  this->controller_.set_state(this->ack_state_);
+  const bool retry = this->ack_attempts_ < this->ack_retries_;
+  if (this->ack_stop_) {
+    // Still running the way it went, from where the press found it
+    const CoverOperation dir =
+        this->ack_state_ == CONTROLLER_OPENING ? COVER_OPERATION_OPENING : COVER_OPERATION_CLOSING;
+    this->position =
+        from_motion(this->travel_from_(this->ack_state_, this->ack_position_, millis() - this->ack_press_time_));
+    this->lead_stop_dir_ = this->run_dir_ = COVER_OPERATION_IDLE;
+    this->set_current_operation_(dir, false);
+    if (!retry) {
+      ESP_LOGW(TAG, "Gate did not stop after %u press(es), letting it run to the end", this->ack_attempts_ + 1);
+      return;
+    }
+    this->ack_attempts_++;
+    ESP_LOGW(TAG, "Gate still moving %ums after the stop press, sending it again (retry %u/%u)", this->ack_timeout_,
+             this->ack_attempts_, this->ack_retries_);
+    this->start_direction_(COVER_OPERATION_IDLE);
+    return;
+  }
+  const CoverOperation dir = this->current_operation;
+  if (dir == COVER_OPERATION_IDLE || this->current_trigger_operation_ != dir) {
+    return;
+  }
+  // Still where it stood
+  this->position = from_motion(this->ack_position_);
+  if (!retry) {
+    ESP_LOGW(TAG, "No motion after %u press(es), giving up", this->ack_attempts_ + 1);
+    this->lead_stop_dir_ = this->run_dir_ = COVER_OPERATION_IDLE;
+    this->set_current_operation_(COVER_OPERATION_IDLE, false);
+    return;
+  }
+  this->ack_attempts_++;
+  ESP_LOGW(TAG, "No motion %ums after the press, sending it again (retry %u/%u)", this->ack_timeout_,
+           this->ack_attempts_, this->ack_retries_);
+  // Planned again from the restored state; its starts count towards safety_max_cycles
+  this->start_direction_(dir);
+}
+
+void ImpulseCover::cancel_ack_() {
+  if (this->ack_pending_) {
+    this->ack_pending_ = false;
+    this->cancel_timer_(TIMER_PULSE_ACK);
+  }
+}
+
+void ImpulseCover::arm_motion_timers_() {
+  this->arm_target_timer_();
+  this->arm_timer_(TIMER_MOTION_SAFETY, this->safety_timeout_);
+  if (!this->publish_transitions_only_) {
+    this->arm_timer_(TIMER_MOTION_PUBLISH, this->publish_min_interval_, this->publish_min_interval_);
+  }
+  
+  // The cycle count only changes when a move starts, so this is the one place to check it
+  this->check_safety_();
+}
+
+void ImpulseCover::arm_target_timer_() {
+  if (this->lead_in_) {
+    // Armed by the press that ends the lead-in
+    return;
+  }
+  uint32_t to_target = this->time_to_position_(this->target_position_);
+  if (this->is_intermediate_target_()) {
+    // Stop pulse goes out early by the coast the gate needs to come to rest
+    const uint32_t lead = static_cast<uint32_t>(this->stop_lead_(this->current_operation));
+    to_target = to_target > lead ? to_target - lead : 0;
+  }
+  // Relative to the anchor of the move; a new target can arrive while it runs
+  const uint32_t elapsed = millis() - this->anchor_time_;
+  to_target = to_target > elapsed ? to_target - elapsed : 0;
+  ESP_LOGV(TAG, "Arming motion deadline in %ums", to_target);
+  
+  this->arm_timer_(TIMER_MOTION_TARGET, to_target);
+}
+
+void ImpulseCover::cancel_motion_timers_() {
+  this->cancel_timer_(TIMER_MOTION_TARGET);
+  this->cancel_timer_(TIMER_MOTION_SAFETY);
+  this->cancel_timer_(TIMER_MOTION_PUBLISH);
+}
+
+#ifndef IMPULSE_COVER_ZERO_HEAP
+static const char *const TIMER_NAMES[TIMER_COUNT] = {
+    "pulse",          "pulse_defer",    "command_settle", "motion_target",
+    "motion_safety",  "motion_publish", "state_save",     "pulse_ack",
+};
+#endif
+
+void ImpulseCover::arm_timer_(TimerId id, uint32_t delay, uint32_t period) {
+#ifdef IMPULSE_COVER_ZERO_HEAP
+  this->timers_.set(id, millis(), delay, period);
+  this->enable_loop();
+#else
+  // Re-arming by name replaces the pending timeout; the capture fits the function's inline storage
+  if (period != 0) {
+    this->set_interval(TIMER_NAMES[id], period, [this, id]() { this->on_timer_(id); });
+  } else {
+    this->set_timeout(TIMER_NAMES[id], delay, [this, id]() { this->on_timer_(id); });
+  }
+#endif
+}
+
+void ImpulseCover::cancel_timer_(TimerId id) {
+#ifdef IMPULSE_COVER_ZERO_HEAP
+  this->timers_.cancel(id);
+#else
+  if (id == TIMER_MOTION_PUBLISH) {
+    this->cancel_interval(TIMER_NAMES[id]);
+  } else {
+    this->cancel_timeout(TIMER_NAMES[id]);
+  }
+#endif
+}
+
+void ImpulseCover::on_timer_(TimerId id) {
+  switch (id) {
+    case TIMER_PULSE:
+      if (this->pulse_sequencer_.is_running()) {
+        this->run_pulse_step_(this->pulse_sequencer_.next());
+      }
+      break;
+    case TIMER_PULSE_DEFER:
+      this->send_pattern_(this->deferred_pattern_, this->deferred_output_);
+      break;
+    case TIMER_COMMAND_SETTLE:
+      this->apply_queued_command_();
+      break;
+    case TIMER_MOTION_TARGET:
+      this->recompute_position_();
+      if (this->awaits_motor_stop_()) {
+        ESP_LOGD(TAG, "Motor still running, waiting for it to stop at the end");
+        break;
+      }
+      if (this->ack_pending_ && !this->ack_stop_) {
+        // Re-armed once the gate shows it started; a stop press would start a gate that did not
+        ESP_LOGD(TAG, "Target due before the gate showed motion, waiting");
+        break;
+      }
+      this->position = from_motion(this->target_position_);  // Absorb rounding at the deadline
+      this->on_target_reached_();
+      break;
+    case TIMER_MOTION_SAFETY:
+      this->recompute_position_();
+      this->on_safety_timeout_();
+      break;
+    case TIMER_MOTION_PUBLISH:
+      this->recompute_position_();
+      this->publish_state_(PUBLISH_PROGRESS);
+      break;
+    case TIMER_STATE_SAVE:
+      this->request_save_();
+      break;
+    case TIMER_PULSE_ACK:
+      this->on_ack_timeout_();
+      break;
+    default:
+      break;
+  }
+}
+
+void ImpulseCover::recompute_position_() {
+  if (this->lead_in_) {
+    this->position = from_motion(this->lead_in_position_at_(millis()));
+    return;
+  }
+  if (this->current_operation == COVER_OPERATION_IDLE)
+    return;
+
+  this->position = from_motion(this->position_at_(millis()));
+}
+
+motion_t ImpulseCover::position_at_(uint32_t now) const {
+  // Closed form from the move snapshot: no error accumulates over a long travel
+  const motion_t time = this->start_offset_ + motion_travel(now - this->anchor_time_, this->motion_rate_);
+  return this->curve_position_(this->current_operation, time);
+}
+
+uint32_t ImpulseCover::time_to_position_(motion_t target) const {
+  // Inverse of position_at_(): milliseconds after anchor_time_ at which the move reaches target
+  const motion_t time = this->curve_time_(this->current_operation, target);
+  return time > this->start_offset_ ? motion_time(time - this->start_offset_, this->move_duration_) : 0;
+}
+
+motion_t ImpulseCover::curve_time_(CoverOperation dir, motion_t position) const {
+  // Fraction of a full run in direction dir after which position is reached
+  if (dir == COVER_OPERATION_OPENING) {
+    return this->open_curve_ != nullptr ? this->open_curve_->motion_time_at(position) : position;
+  }
+  const motion_t progress = MOTION_ONE - position;
+  return this->close_curve_ != nullptr ? this->close_curve_->motion_time_at(progress) : progress;
+}
+
+motion_t ImpulseCover::curve_position_(CoverOperation dir, motion_t time) const {
+  // Position reached after a fraction time of a full run in direction dir
+  const TravelCurve *curve = dir == COVER_OPERATION_OPENING ? this->open_curve_ : this->close_curve_;
+  const motion_t progress = std::min(curve != nullptr ? curve->motion_progress_at(time) : time, MOTION_ONE);
+  return dir == COVER_OPERATION_OPENING ? progress : MOTION_ONE - progress;
+}
+
+bool ImpulseCover::is_at_target_() const {
+  // An intermediate target is reached once a stop pulse sent now would make
+  // the gate come to rest on it
+  if (this->awaits_motor_stop_() || (this->ack_pending_ && !this->ack_stop_)) {
+    return false;
+  }
+  motion_t position;
+  if (this->current_operation == COVER_OPERATION_IDLE) {
+    position = to_motion(this->position);
+  } else if (this->is_intermediate_target_() && this->current_operation == this->current_trigger_operation_) {
+    position = this->position_at_(millis() + static_cast<uint32_t>(this->stop_lead_(this->current_operation)));
+  } else {
+    position = this->position_at_(millis());
+  }
+  
+  switch (this->current_trigger_operation_) {
+    case COVER_OPERATION_OPENING:
+      return position >= this->target_position_;
+    case COVER_OPERATION_CLOSING:
+      return position <= this->target_position_;
+    case COVER_OPERATION_IDLE:
+      return this->current_operation == COVER_OPERATION_IDLE;
+    default:
+      return true;
+  }
+}
+
+// Private helper methods
+void ImpulseCover::write_output_(bool state) {
+  if (state == this->relay_closed_)
+    return;
+  this->relay_closed_ = state;
+  this->trace_(TRACE_PULSE, state, this->running_output_);
+  const uint32_t now = millis();
+  if (state) {
+    this->pulse_on_time_ = now;
+    if (this->latency_pending_) {
+      this->stats_.command_latency.add(now - this->command_time_);
+      this->latency_pending_ = false;
+    }
+  } else {
+    // Against the press step that closed the relay
+    const uint32_t width = now - this->pulse_on_time_;
+    this->stats_.pulse_jitter.add(width > this->press_width_ ? width - this->press_width_ : this->press_width_ - width);
+  }
+  if (state) {
+    this->outputs_[this->running_output_]->turn_on();
+  } else {
+    this->outputs_[this->running_output_]->turn_off();
+  }
+}
+
+void ImpulseCover::trace_(TraceEvent event, uint8_t arg, uint16_t value) {
+  this->event_trace_.record(millis(), event, arg, value);
+}
+
+void ImpulseCover::dump_trace() {
+  if (!this->event_trace_.enabled()) {
+    ESP_LOGW(TAG, "Event trace is disabled (trace_size: 0)");
+    return;
+  }
+  // The header carries what a replay needs besides the records
+  ESP_LOGI(TAG, "Trace: %u records, %u dropped, now %u, open %u, close %u, pulse %u, sensors %c%c",
+           this->event_trace_.size(), this->event_trace_.dropped(), millis(), this->open_duration_,
+           this->close_duration_, this->pulse_delay_, this->trace_sensor_flag_(true),
+           this->trace_sensor_flag_(false));
+  char line[16 * EventTrace::RECORDS_PER_LINE + 1];
+  for (uint16_t i = 0; i < this->event_trace_.size(); i += EventTrace::RECORDS_PER_LINE) {
+    this->event_trace_.encode_line(i, line);
+    ESP_LOGI(TAG, "Trace %04u: %s", i, line);
+  }
+}
+
+char ImpulseCover::trace_sensor_flag_(bool open_endstop) const {
+  // '-' none, 'n' normal, 'i' inverted
+#ifdef USE_BINARY_SENSOR
+  if (open_endstop ? this->open_sensor_ != nullptr : this->close_sensor_ != nullptr) {
+    return this->sensor_inverted_(open_endstop) ? 'i' : 'n';
+  }
+#endif
+  return '-';
+}
+
+void ImpulseCover::init_pulse_patterns_() {
+  // Patterns not set in YAML are built from pulse_delay: a press of pulse_delay, and for the
+  // double pulse a pause of twice that before the second press. Stop is a single press.
+  PulseSequencer &seq = this->pulse_sequencer_;
+  if (seq.get_step_count(PULSE_SINGLE) == 0) {
+    seq.add_step(PULSE_SINGLE, true, this->pulse_delay_);
+  }
+  if (seq.get_step_count(PULSE_DOUBLE) == 0) {
+    seq.add_step(PULSE_DOUBLE, true, this->pulse_delay_);
+    seq.add_step(PULSE_DOUBLE, false, 2 * this->pulse_delay_);
+    seq.add_step(PULSE_DOUBLE, true, this->pulse_delay_);
+  }
+  if (seq.get_step_count(PULSE_STOP) == 0) {
+    for (uint8_t i = 0; i < seq.get_step_count(PULSE_SINGLE); i++) {
+      const PulseStep &step = seq.get_step(PULSE_SINGLE, i);
+      seq.add_step(PULSE_STOP, step.press, step.duration);
+    }
+  }
+}
+
+bool ImpulseCover::plan_pulses_(ControllerGoal goal, PulsePlan &plan, PulseOutput &output) {
+  // Anything not yet sent is replaced by the new plan
+  this->cancel_pending_pulses_();
+  this->sync_controller_();
+  output = this->direct_output_(goal);
+  if (output != PULSE_OUTPUT_IMPULSE) {
+    this->plan_direct_(goal, plan);
+    if (plan.cut) {
+      this->pulse_sequencer_.truncate();
+    }
+    ESP_LOGD(TAG, "Plan to %s from %s: %s press on the %s output", pulse_output_to_str(output),
+             controller_state_to_str(this->controller_.get_state()), pulse_pattern_to_str(plan.patterns[0]),
+             pulse_output_to_str(output));
+    return true;
+  }
+  const uint32_t now = millis();
+  const uint32_t since_pulse = now - this->last_pulse_time_;
+  const int32_t step_left = static_cast<int32_t>(this->step_deadline_ - now);
+  PlanRequest request{};
+  request.state = this->controller_.get_state();
+  request.goal = goal;
+  request.position = to_motion(this->position);
+  request.target = this->target_position_;
+  request.running = this->pulse_sequencer_.is_running();
+  request.step_left = request.running && step_left > 0 ? step_left : 0;
+  request.gap_left = since_pulse < this->pulse_delay_ ? this->pulse_delay_ - since_pulse : 0;
+  request.budget = this->starts_left_();
+
+  const PulsePlanner planner(this->controller_, this->pulse_sequencer_, this->pulse_delay_, this->open_duration_,
+                             this->close_duration_);
+  const uint8_t options = planner.plan(request, plan);
+  const char *goal_str = goal == CONTROLLER_GOAL_STOP ? "stop" : goal == CONTROLLER_GOAL_OPEN ? "open" : "close";
+  if (options == 0) {
+    ESP_LOGD(TAG, "Controller %s: no plan to %s", controller_state_to_str(request.state), goal_str);
+    return false;
+  }
+  if (plan.cut) {
+    this->pulse_sequencer_.truncate();
+  }
+
+  char patterns[32] = "none";
+  size_t len = 0;
+  for (uint8_t i = 0; i < plan.count; i++) {
+    len += snprintf(patterns + len, sizeof(patterns) - len, i == 0 ? "%s" : "+%s",
+                    pulse_pattern_to_str(plan.patterns[i]));
+  }
+  const char *running = !request.running ? "" : plan.cut ? ", running pattern cut" : ", after running pattern";
+  ESP_LOGD(TAG, "Plan to %s from %s%s: %s, %u press(es), %u start(s), %ums to %s (best of %u)", goal_str,
+           controller_state_to_str(request.state), running, patterns, plan.presses, plan.starts, plan.time,
+           goal == CONTROLLER_GOAL_STOP ? "the stop press" : "target", options);
+  return true;
+}
+
+PulseOutput ImpulseCover::direct_output_(ControllerGoal goal) const {
+  // cover.py has open and close outputs come as a pair; without a stop output, stops cycle the impulse input
+  if (this->outputs_[PULSE_OUTPUT_OPEN] == nullptr) {
+    return PULSE_OUTPUT_IMPULSE;
+  }
+  switch (goal) {
+    case CONTROLLER_GOAL_OPEN:
+      return PULSE_OUTPUT_OPEN;
+    case CONTROLLER_GOAL_CLOSE:
+      return PULSE_OUTPUT_CLOSE;
+    default:
+      return this->outputs_[PULSE_OUTPUT_STOP] != nullptr ? PULSE_OUTPUT_STOP : PULSE_OUTPUT_IMPULSE;
+  }
+}
+
+void ImpulseCover::plan_direct_(ControllerGoal goal, PulsePlan &plan) const {
+  // A dedicated input takes the controller to the goal in one press, whatever state it is
+  // in. It needs no pulse_delay_ gap, only the step in progress on the relay to end.
+  const int32_t step_left = static_cast<int32_t>(this->step_deadline_ - millis());
+  const ControllerState state = this->controller_.get_state();
+  plan.patterns[0] = goal == CONTROLLER_GOAL_STOP ? PULSE_STOP : PULSE_SINGLE;
+  plan.count = 1;
+  plan.presses = 1;
+  plan.starts = goal != CONTROLLER_GOAL_STOP && !ControllerFsm::reaches(state, goal);
+  plan.cut = this->pulse_sequencer_.is_running();
+  plan.lead = plan.cut && step_left > 0 ? step_left : 0;
+  plan.time = plan.lead;
+  plan.from = to_motion(this->position);
+}
+
+void ImpulseCover::sync_controller_() {
+  // A cover at rest at an end, by its estimate or after an endstop correction, has the
+  // controller waiting to move away from it
+  if (this->current_operation != COVER_OPERATION_IDLE || this->pulse_sequencer_.is_running()) {
+    return;
+  }
+  if (this->position >= COVER_OPEN || this->position <= COVER_CLOSED) {
+    this->controller_.at_end(this->position >= COVER_OPEN);
+  }
+}
+
+void ImpulseCover::send_plan_(const PulsePlan &plan, PulseOutput output) {
+  // The first pattern goes out now, or as soon as the relay is free; each
+  // following one pulse_delay_ after the previous one ends
+  this->plan_ = plan;
+  this->plan_output_ = output;
+  this->plan_next_ = 0;
+  if (plan.count > 0) {
+    this->send_pattern_(this->plan_.patterns[this->plan_next_++], output);
+  }
+}
+
+void ImpulseCover::cancel_pending_pulses_() {
+  this->cancel_timer_(TIMER_PULSE_DEFER);
+  this->pulse_queued_ = false;
+  this->plan_next_ = this->plan_.count;
+}
+
+void ImpulseCover::send_pattern_(PulsePattern pattern, PulseOutput output) {
+  ESP_LOGV(TAG, "send_pattern_ called with %s on the %s output", pulse_pattern_to_str(pattern),
+           pulse_output_to_str(output));
+  
+  if (this->outputs_[output] == nullptr) {
+    ESP_LOGE(TAG, "Output is null! Cannot send pulse");
+    return;
+  }
+  
+  const uint32_t now = millis();
+  ESP_LOGV(TAG, "Current time: %u, last_pulse_time_: %u, pulse_delay_: %u", 
+           now, this->last_pulse_time_, this->pulse_delay_);
+  
+  if (this->pulse_sequencer_.is_running()) {
+    // Relay sequences never interleave: this one follows pulse_delay_ after the running one
+    // ends, which the plan may have cut short after the step in progress. Checked first, so
+    // the end of the running sequence finds it queued.
+    ESP_LOGV(TAG, "Pulse sequence running, queueing %s pulse", pulse_pattern_to_str(pattern));
+    this->stats_.deferred_pulses++;
+    this->deferred_pattern_ = pattern;
+    this->deferred_output_ = output;
+    this->pulse_queued_ = true;
+    return;
+  }
+  // Check if enough time has passed since last pulse; only the impulse input counts presses
+  if (output == PULSE_OUTPUT_IMPULSE && (now - this->last_pulse_time_) < this->pulse_delay_) {
+    ESP_LOGV(TAG, "Pulse too rapid, delaying %s pulse", pulse_pattern_to_str(pattern));
+    
+    this->stats_.deferred_pulses++;
+    this->deferred_pattern_ = pattern;
+    this->deferred_output_ = output;
+    this->arm_timer_(TIMER_PULSE_DEFER, this->pulse_delay_ - (now - this->last_pulse_time_));
+    return;
+  }
+  
+  ESP_LOGD(TAG, "Sending %s control pulse", pulse_pattern_to_str(pattern));
+  if (pattern == PULSE_DOUBLE) {
+    this->stats_.double_pulses++;
+  } else {
+    this->stats_.pulses++;
+  }
+  this->step_deadline_ = now;
+  this->running_output_ = output;
+  this->run_pulse_step_(this->pulse_sequencer_.start(pattern));
+  
+  if (output == PULSE_OUTPUT_IMPULSE) {
+    this->last_pulse_time_ = millis();
+  }
+  this->pulse_sent_ = true;
+  ESP_LOGV(TAG, "Pulse sequence initiated, pulse_sent_ set to true");
+}
+
+void ImpulseCover::run_pulse_step_(const PulseStep *step) {
+  if (step == nullptr) {
+    // Sequence done: the relay opens, and a pulse held back for it follows after pulse_delay_,
+    // or right away on a dedicated input
+    this->write_output_(false);
+    if (this->pulse_queued_) {
+      this->pulse_queued_ = false;
+      this->arm_timer_(TIMER_PULSE_DEFER, this->deferred_output_ == PULSE_OUTPUT_IMPULSE ? this->pulse_delay_ : 0);
+    } else if (this->plan_next_ < this->plan_.count) {
+      this->deferred_pattern_ = this->plan_.patterns[this->plan_next_++];
+      this->deferred_output_ = this->plan_output_;
+      this->arm_timer_(TIMER_PULSE_DEFER, this->pulse_delay_);
+    }
+    return;
+  }
+  if (step->press) {
+    this->press_width_ = step->duration;
+    if (!this->relay_closed_) {
+      this->on_press_();
+    }
+  }
+  this->write_output_(step->press);
+  // Each step ends relative to the previous deadline, so loop latency does not add up
+  this->step_deadline_ += step->duration;
+  const int32_t remaining = static_cast<int32_t>(this->step_deadline_ - millis());
+  this->arm_timer_(TIMER_PULSE, remaining > 0 ? remaining : 0);
+}
+
+void ImpulseCover::check_safety_() {
+  if (this->current_operation == COVER_OPERATION_IDLE || this->safety_triggered_) {
+    return;
+  }
+  
+  // Check cycle count safety
+  if (this->safety_cycle_count_ >= this->safety_max_cycles_) {
+    this->trip_cycle_safety_(this->safety_cycle_count_);
+  }
+}
+
+uint8_t ImpulseCover::starts_left_() const {
+  // check_safety_() trips once the count reaches the maximum
+  return this->safety_max_cycles_ > this->safety_cycle_count_ + 1
+             ? this->safety_max_cycles_ - this->safety_cycle_count_ - 1
+             : 0;
+}
+
+void ImpulseCover::trip_cycle_safety_(uint8_t cycles) {
+  ESP_LOGW(TAG, "Safety max cycles triggered (%u cycles)", cycles);
+  this->trace_(TRACE_SAFETY, TRACE_SAFETY_CYCLES, cycles);
+  this->stats_.safety_trips++;
+  // Stop first: once safety is triggered start_direction_() refuses to act and the
+  // cover would stay "moving", tripping again on every loop
+  if (this->current_operation != COVER_OPERATION_IDLE) {
+    this->start_direction_(COVER_OPERATION_IDLE);
+  }
+  this->safety_triggered_ = true;
+  this->fire_triggers_(TRIGGER_SAFETY);
+}
+
+#ifdef USE_BINARY_SENSOR
+bool ImpulseCover::reconcile_at_end_(bool open_endstop, bool is_initialization) {
+  const float endstop = open_endstop ? COVER_OPEN : COVER_CLOSED;
+  const char *name = open_endstop ? "OPEN" : "CLOSED";
+  if (!is_initialization && this->position == endstop) {
+    return false;
+  }
+  const float old_position = this->position;
+  this->position = endstop;
+  if (is_initialization) {
+    this->has_initial_state_ = true;
+    ESP_LOGI(TAG, "Initial state: %s (endstop sensor active)", name);
+  } else {
+    ESP_LOGW(TAG, "Position misalignment detected: position=%.3f but endstop sensor active - correcting to %s",
+             old_position, name);
+  }
+  return true;
+}
+
+bool ImpulseCover::reconcile_not_at_end_(bool open_sensor, bool is_initialization) {
+  // A single sensor that is inactive rules out its own endstop; assume the other one
+  const float assumed = open_sensor ? COVER_CLOSED : COVER_OPEN;
+  if (is_initialization) {
+    this->position = assumed;
+    this->has_initial_state_ = false;
+    ESP_LOGD(TAG, "Initial state: %s (%s sensor inactive, assuming %s)", open_sensor ? "CLOSED" : "OPEN",
+             open_sensor ? "open" : "close", open_sensor ? "closed" : "open");
+    return false;
+  }
+  if (this->position != (open_sensor ? COVER_OPEN : COVER_CLOSED)) {
+    return false;
+  }
+  ESP_LOGW(TAG, "Position misalignment detected: position=%s but %s sensor inactive - correcting to %s",
+           open_sensor ? "OPEN" : "CLOSED", open_sensor ? "open" : "close", open_sensor ? "CLOSED" : "OPEN");
+  this->position = assumed;
+  return true;
+}
+
+bool ImpulseCover::reconcile_between_(bool is_initialization) {
+  if (is_initialization) {
+    this->position = 0.5f;  // Unknown position - intermediate
+    this->has_initial_state_ = false;
+    ESP_LOGD(TAG, "Initial state: UNKNOWN (neither sensor active) - position set to 50%%");
+    return false;
+  }
+  if (this->position != COVER_OPEN && this->position != COVER_CLOSED) {
+    return false;
+  }
+  // Position indicates endpoint but no sensor active - misalignment
+  ESP_LOGW(TAG, "Position misalignment detected: position=%s but no sensor active - correcting to intermediate", 
+           this->position == COVER_OPEN ? "OPEN" : "CLOSED");
+  this->position = 0.5f;
+  return true;
+}
+
+bool ImpulseCover::reconcile_conflict_(bool is_initialization) {
+  // Both sensors active - should not happen, probably misconfiguration
+  if (is_initialization) {
+    ESP_LOGW(TAG, "Both sensors active simultaneously - possible misconfiguration!");
+    this->position = 0.5f;  // Unknown position
+    this->has_initial_state_ = false;
+    ESP_LOGD(TAG, "Initial state: CONFLICT (both sensors active) - position set to 50%%");
+  } else {
+    ESP_LOGW(TAG, "Sensor conflict detected: both sensors active simultaneously!");
+  }
+  return false;
+}
+
+void ImpulseCover::reconcile_none_(bool is_initialization) {
+  if (is_initialization) {
+    ESP_LOGV(TAG, "No sensors configured - keeping current position: %.2f", this->position);
+  }
+}
+
+void ImpulseCover::apply_reconciliation_(bool position_updated, bool is_initialization) {
+  if (is_initialization) {
+    return;
+  }
+  if (position_updated) {
+    ESP_LOGI(TAG, "Position corrected based on sensor feedback");
+    this->feedback_.rebase(to_motion(this->position));
+    this->trace_(TRACE_CORRECTION, 0, EventTrace::encode_position(this->position));
+    this->stats_.corrections++;
+    this->publish_state_(PUBLISH_TRANSITION);
+    this->request_save_();
+  } else {
+    ESP_LOGV(TAG, "Sensor alignment check passed - no correction needed");
+  }
+}
+
+void ImpulseCover::check_sensor_alignment_() {
+  ESP_LOGV(TAG, "Checking sensor alignment with current position...");
+  ESP_LOGV(TAG, "Current position: %.3f", this->position);
+  this->update_position_from_sensors_(false);
+}
+
+void ImpulseCover::endstop_reached_(bool open_endstop) {
+  ESP_LOGV(TAG, "endstop_reached_ called - open_endstop=%s", open_endstop ? "true" : "false");
+  this->arrive_at_end_(open_endstop, this->endstop_time_(open_endstop, millis()));
+  ESP_LOGV(TAG, "endstop_reached_ completed");
+}
+
+uint32_t ImpulseCover::endstop_time_(bool open_endstop, uint32_t now) {
+  // The interrupt edge behind this callback if there is one, else the callback itself
+  uint32_t edge_us;
+  if (!this->endstop_edges_[open_endstop ? 0 : 1].last_activation(edge_us)) {
+    return now;
+  }
+  const uint32_t age = (micros() - edge_us) / 1000;
+  if (age > ENDSTOP_EDGE_MAX_AGE) {
+    return now;
+  }
+  this->stats_.endstop_delay.add(age);
+  return now - age;
+}
+#endif
+
+void ImpulseCover::arrive_at_end_(bool open_endstop, uint32_t now) {
+  // At an end at now, from its endstop or from the motor stopping there
+  ESP_LOGV(TAG, "Current state: position=%.3f, current_operation=%d, current_trigger_operation_=%d", 
+           this->position, static_cast<int>(this->current_operation), static_cast<int>(this->current_trigger_operation_));
+  ESP_LOGV(TAG, "Expected operation for this endstop: %d", 
            static_cast<int>(open_endstop ? COVER_OPERATION_OPENING : COVER_OPERATION_CLOSING));
   
   // Set position based on endstop
   float old_position = this->position;
   this->position = open_endstop ? COVER_OPEN : COVER_CLOSED;
+  this->feedback_.rebase(to_motion(this->position));
   ESP_LOGD(TAG, "Position updated from %.3f to %.3f (%s endstop)", 
            old_position, this->position, open_endstop ? "OPEN" : "CLOSE");
   
@@ -604,8 +1742,16 @@ void ImpulseCover::endstop_reached_(bool open_endstop) {
   bool is_correct_direction = (this->current_trigger_operation_ == (open_endstop ? COVER_OPERATION_OPENING : COVER_OPERATION_CLOSING));
   ESP_LOGV(TAG, "Direction check: is_correct_direction=%s", is_correct_direction ? "true" : "false");
   
+  const CoverOperation arrived = open_endstop ? COVER_OPERATION_OPENING : COVER_OPERATION_CLOSING;
+  this->stats_.endstop_arrivals++;
+  if (this->predicted_dir_ == arrived) {
+    const int32_t error = static_cast<int32_t>(now - this->predicted_arrival_);
+    this->stats_.arrival_error.add(error < 0 ? -error : error);
+    this->predicted_dir_ = COVER_OPERATION_IDLE;
+  }
+  const bool timed_run = this->run_dir_ == arrived && now - this->run_start_ < this->safety_timeout_;
   if (is_correct_direction) {
-    float dur = (now - this->start_dir_time_) / 1e3f;
+    float dur = (now - (timed_run ? this->run_start_ : this->start_dir_time_)) / 1e3f;
     ESP_LOGI(TAG, "'%s' - %s endstop reached. Took %.1fs.",
              this->get_name().c_str(), open_endstop ? "Open" : "Close", dur);
   } else {
@@ -615,77 +1761,273 @@ void ImpulseCover::endstop_reached_(bool open_endstop) {
              static_cast<int>(open_endstop ? COVER_OPERATION_OPENING : COVER_OPERATION_CLOSING));
   }
   
+  if (timed_run) {
+    // A run from the last stop's rest position: its length tells where that really was
+    if (this->lead_stop_dir_ != COVER_OPERATION_IDLE) {
+      const uint32_t run_dur = open_endstop ? this->open_duration_ : this->close_duration_;
+      const uint32_t elapsed = now - this->run_start_;
+      if (elapsed <= run_dur) {
+        const motion_t start_time = MOTION_ONE - motion_travel(elapsed, motion_rate(run_dur));
+        this->observe_stop_lead_(this->curve_position_(arrived, start_time));
+      }
+    }
+    if (this->run_from_endstop_ && this->learn_durations_) {
+      this->observe_duration_(arrived, now - this->run_start_);
+    }
+  }
+  this->lead_stop_dir_ = this->run_dir_ = COVER_OPERATION_IDLE;
+  this->controller_.at_end(open_endstop);
+  
   ESP_LOGV(TAG, "Stopping operation and setting to IDLE");
   this->set_current_operation_(COVER_OPERATION_IDLE, false);
-  ESP_LOGV(TAG, "endstop_reached_ completed");
 }
 
-bool ImpulseCover::get_sensor_state_(binary_sensor::BinarySensor *sensor, bool inverted) {
-  return sensor ? (inverted ? !sensor->state : sensor->state) : false;
+void ImpulseCover::observe_stop_lead_(motion_t actual_rest) {
+  // Distance past the assumed rest position, in ms of travel in the stopped direction
+  const CoverOperation dir = this->lead_stop_dir_;
+  const float dur = dir == COVER_OPERATION_OPENING ? this->open_duration_ : this->close_duration_;
+  const float error_ms = (from_motion(this->curve_time_(dir, actual_rest)) -
+                          from_motion(this->curve_time_(dir, this->lead_rest_position_))) * dur;
+  if (std::fabs(error_ms) > STOP_LEAD_MAX_MS) {
+    ESP_LOGD(TAG, "Ignoring stop lead observation of %+.0fms", error_ms);
+    return;
+  }
+  
+  float &lead = dir == COVER_OPERATION_OPENING ? this->open_stop_lead_ : this->close_stop_lead_;
+  const float old_lead = lead;
+  lead = clamp(lead + STOP_LEAD_GAIN * error_ms, 0.0f, STOP_LEAD_MAX_MS);
+  ESP_LOGI(TAG, "'%s' - %s stop lead %.0fms -> %.0fms (rest error %+.0fms)", this->get_name().c_str(),
+           dir == COVER_OPERATION_OPENING ? "Open" : "Close", old_lead, lead, error_ms);
+  this->save_learned_state_();
+  this->publish_diagnostics_();
+}
+
+void ImpulseCover::observe_duration_(CoverOperation dir, uint32_t elapsed) {
+  const bool opening = dir == COVER_OPERATION_OPENING;
+  const uint32_t configured = opening ? this->configured_open_duration_ : this->configured_close_duration_;
+  if (std::fabs(float(elapsed) - configured) > DURATION_BOUND * configured) {
+    ESP_LOGD(TAG, "Ignoring %s run of %ums: too far from the configured %ums", opening ? "open" : "close", elapsed,
+             configured);
+    return;
+  }
+  
+  // Keep the last full-run times; a sample far from their median is an outlier
+  // (obstacle, manual stop and restart), while a lasting drift moves the median
+  uint32_t *samples = this->duration_samples_[opening ? 0 : 1];
+  uint8_t &count = this->duration_sample_count_[opening ? 0 : 1];
+  if (count < DURATION_SAMPLES) {
+    count++;
+  }
+  std::copy_backward(samples, samples + DURATION_SAMPLES - 1, samples + DURATION_SAMPLES);
+  samples[0] = elapsed;
+  
+  uint32_t &duration = opening ? this->open_duration_ : this->close_duration_;
+  if (count >= 3) {
+    uint32_t sorted[DURATION_SAMPLES];
+    std::copy(samples, samples + count, sorted);
+    std::nth_element(sorted, sorted + count / 2, sorted + count);
+    const float median = sorted[count / 2];
+    if (std::fabs(elapsed - median) > DURATION_OUTLIER * median) {
+      ESP_LOGD(TAG, "Ignoring %s run of %ums: outlier against recent median %.0fms", opening ? "open" : "close",
+               elapsed, median);
+      return;
+    }
+  }
+  
+  const uint32_t old_duration = duration;
+  duration = static_cast<uint32_t>(std::lround(duration + DURATION_GAIN * (float(elapsed) - duration)));
+  ESP_LOGI(TAG, "'%s' - %s duration %ums -> %ums (run took %ums)", this->get_name().c_str(),
+           opening ? "Open" : "Close", old_duration, duration, elapsed);
+  this->save_learned_state_();
+  this->publish_diagnostics_();
+}
+
+#ifdef USE_BINARY_SENSOR
+bool ImpulseCover::at_endstop_(bool open_endstop) {
+  if (this->position != (open_endstop ? COVER_OPEN : COVER_CLOSED))
+    return false;
+  const bool has_sensor = (open_endstop ? this->open_sensor_ : this->close_sensor_) != nullptr;
+  return !has_sensor || this->endstop_active_(open_endstop);
 }
 
 void ImpulseCover::set_open_sensor(binary_sensor::BinarySensor *sensor) {
   this->open_sensor_ = sensor;
   if (sensor) {
     sensor->add_on_state_callback([this](bool state) {
-      if (this->get_sensor_state_(this->open_sensor_, this->open_sensor_inverted_)) {
-         this->endstop_reached_(true);
+      this->trace_(TRACE_SENSOR, 0, state);
+      if (this->endstop_active_(true)) {
+        this->endstop_reached_(true);
+      } else {
+        this->on_ack_(true, millis());
       }
     });
   }
 }
 
+void ImpulseCover::add_position_mark(binary_sensor::BinarySensor *sensor, float position) {
+  if (this->mark_count_ == MAX_POSITION_MARKS) {
+    ESP_LOGE(TAG, "More than %u position marks, ignoring the one at %.1f%%", MAX_POSITION_MARKS, position * 100.0f);
+    return;
+  }
+  const motion_t mark = to_motion(position);
+  this->mark_positions_[this->mark_count_++] = mark;
+  sensor->add_on_state_callback([this, mark](bool state) {
+    if (state) {
+      this->on_ack_(true, millis());
+      this->feedback_.rebase(mark);
+      this->fix_position_(mark);
+    }
+  });
+}
+
 void ImpulseCover::set_close_sensor(binary_sensor::BinarySensor *sensor) {
   this->close_sensor_ = sensor;
   if (sensor) {
     sensor->add_on_state_callback([this](bool state) {
-      if (this->get_sensor_state_(this->close_sensor_, this->close_sensor_inverted_)) {
+      this->trace_(TRACE_SENSOR, 1, state);
+      if (this->endstop_active_(false)) {
         this->endstop_reached_(false);
-      } 
+      } else {
+        this->on_ack_(true, millis());
+      }
     });
   }
 }
 #endif
-
-// Automation trigger methods
-void ImpulseCover::add_on_open_trigger(Trigger<> *trigger) {
-  this->on_open_triggers_.push_back(trigger);
+#ifdef USE_SENSOR
+void ImpulseCover::set_encoder(sensor::Sensor *sensor, float counts_per_travel) {
+  this->encoder_sensor_ = sensor;
+  this->feedback_.set_counts_per_travel(counts_per_travel);
+  sensor->add_on_state_callback([this](float reading) {
+    if (this->feedback_.count(reading, this->travel_direction_())) {
+      this->on_ack_(true, millis());
+      this->fix_position_(this->feedback_.get_encoder_position());
+    }
+  });
 }
+#endif
 
-void ImpulseCover::add_on_close_trigger(Trigger<> *trigger) {
-  this->on_close_triggers_.push_back(trigger);
+#ifdef USE_SENSOR
+void ImpulseCover::set_current_sensor(sensor::Sensor *sensor) {
+  this->current_sensor_ = sensor;
+  sensor->add_on_state_callback([this](float current) { this->on_current_(current); });
 }
+#endif
 
-void ImpulseCover::add_on_idle_trigger(Trigger<> *trigger) {
-  this->on_idle_triggers_.push_back(trigger);
+void ImpulseCover::save_learned_state_() {
+  if (!this->learn_stop_lead_ && !this->learn_durations_)
+    return;
+  this->learned_dirty_ = true;
+  this->request_save_();
 }
 
-void ImpulseCover::add_on_safety_trigger(SafetyTrigger *trigger) {
-  this->on_safety_triggers_.push_back(trigger);
+void ImpulseCover::request_save_() {
+  // Only a settled cover is persisted; the transition to idle requests the save again
+  if (this->current_operation != COVER_OPERATION_IDLE)
+    return;
+  if (this->position == this->saved_position_ && !this->learned_dirty_)
+    return;
+  
+  const uint32_t now = millis();
+  if (this->has_saved_ && now - this->last_save_time_ < this->min_save_interval_) {
+    // Written together with anything else that changes before the interval ends
+    this->state_saves_coalesced_++;
+    this->arm_timer_(TIMER_STATE_SAVE, this->min_save_interval_ - (now - this->last_save_time_));
+    return;
+  }
+  this->flush_saves_();
 }
 
-// Protected helper methods for firing triggers
-void ImpulseCover::fire_on_open_triggers_() {
-  for (auto *trigger : this->on_open_triggers_) {
-    trigger->trigger();
+void ImpulseCover::flush_saves_() {
+  bool written = false;
+  if (this->position != this->saved_position_) {
+    CoverRestoreState restore{};
+    memset(&restore, 0, sizeof(restore));
+    restore.position = this->position;
+    restore.tilt = this->tilt;
+    this->rtc_.save(&restore);
+    this->saved_position_ = this->position;
+    written = true;
   }
+  if (this->learned_dirty_) {
+    LearnedState state{this->open_stop_lead_, this->close_stop_lead_, this->open_duration_, this->close_duration_};
+    this->learned_pref_.save(&state);
+    this->learned_dirty_ = false;
+    written = true;
+  }
+  if (!written)
+    return;
+  
+  ESP_LOGV(TAG, "State saved (%u writes, %u coalesced)", this->state_saves_ + 1, this->state_saves_coalesced_);
+  this->cancel_timer_(TIMER_STATE_SAVE);
+  this->last_save_time_ = millis();
+  this->has_saved_ = true;
+  this->state_saves_++;
+  this->publish_diagnostics_();
 }
 
-void ImpulseCover::fire_on_close_triggers_() {
-  for (auto *trigger : this->on_close_triggers_) {
-    trigger->trigger();
+void ImpulseCover::publish_diagnostics_() {
+#ifdef USE_SENSOR
+  const PerfStats &stats = this->stats_;
+  const float values[DIAGNOSTIC_SENSOR_COUNT] = {this->open_stop_lead_,
+                                                 this->close_stop_lead_,
+                                                 this->open_duration_ / 1e3f,
+                                                 this->close_duration_ / 1e3f,
+                                                 float(this->state_saves_),
+                                                 float(this->state_saves_coalesced_),
+                                                 float(stats.pulses),
+                                                 float(stats.double_pulses),
+                                                 float(stats.deferred_pulses),
+                                                 float(stats.safety_trips),
+                                                 float(stats.corrections),
+                                                 float(stats.endstop_arrivals),
+                                                 float(stats.loop_time.percentile(0.95f)),
+                                                 float(stats.command_latency.percentile(0.95f)),
+                                                 float(stats.pulse_jitter.percentile(0.95f)),
+                                                 float(stats.arrival_error.percentile(0.95f)),
+                                                 float(stats.coalesced_commands),
+                                                 float(stats.endstop_delay.percentile(0.95f)),
+                                                 float(stats.missed_presses),
+                                                 float(stats.ack_latency.percentile(0.95f))};
+  for (uint8_t i = 0; i < DIAGNOSTIC_SENSOR_COUNT; i++) {
+    if (this->diagnostic_sensors_[i] != nullptr) {
+      this->diagnostic_sensors_[i]->publish_state(values[i]);
+    }
   }
+#endif
+}
+
+// Automation trigger methods
+void ImpulseCover::add_on_open_trigger(Trigger<> *trigger) {
+  this->add_trigger_(TRIGGER_OPEN, trigger);
 }
 
-void ImpulseCover::fire_on_idle_triggers_() {
-  for (auto *trigger : this->on_idle_triggers_) {
-    trigger->trigger();
+void ImpulseCover::add_on_close_trigger(Trigger<> *trigger) {
+  this->add_trigger_(TRIGGER_CLOSE, trigger);
+}
+
+void ImpulseCover::add_on_idle_trigger(Trigger<> *trigger) {
+  this->add_trigger_(TRIGGER_IDLE, trigger);
+}
+
+void ImpulseCover::add_on_safety_trigger(SafetyTrigger *trigger) {
+  this->add_trigger_(TRIGGER_SAFETY, trigger);
+}
+
+void ImpulseCover::add_trigger_(TriggerEvent event, Trigger<> *trigger) {
+  if (this->trigger_count_ == MAX_TRIGGERS) {
+    ESP_LOGE(TAG, "More than %u triggers, ignoring one", MAX_TRIGGERS);
+    return;
   }
+  this->triggers_[this->trigger_count_++] = {event, trigger};
 }
 
-void ImpulseCover::fire_on_safety_triggers_() {
-  for (auto *trigger : this->on_safety_triggers_) {
-    trigger->trigger();
+// Protected helper method for firing triggers
+void ImpulseCover::fire_triggers_(TriggerEvent event) {
+  for (uint8_t i = 0; i < this->trigger_count_; i++) {
+    if (this->triggers_[i].event == event) {
+      this->triggers_[i].trigger->trigger();
+    }
   }
 }
 
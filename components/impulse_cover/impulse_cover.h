@@ -2,14 +2,36 @@
 
 #include "esphome/core/component.h"
 #include "esphome/core/automation.h"
+#include "esphome/core/preferences.h"
 #include "esphome/components/cover/cover.h"
 #include "esphome/components/output/binary_output.h"
+#include "controller_fsm.h"
+#include "current_monitor.h"
+#include "endstop_edge.h"
+#include "event_trace.h"
+#include "motion_math.h"
+#include "perf_stats.h"
+#include "position_feedback.h"
+#include "pulse_planner.h"
+#include "pulse_sequencer.h"
+#ifdef IMPULSE_COVER_ZERO_HEAP
+#include "timer_slots.h"
+#endif
+#include "travel_curve.h"
+#ifdef USE_BINARY_SENSOR
+#include "esphome/components/binary_sensor/binary_sensor.h"
+#endif
 #include <vector>
 
 namespace esphome {
-#ifdef USE_BINARY_SENSOR
-namespace binary_sensor {
-class BinarySensor;
+#ifdef USE_SENSOR
+namespace sensor {
+class Sensor;
+}
+#endif
+#ifdef USE_TEXT_SENSOR
+namespace text_sensor {
+class TextSensor;
 }
 #endif
 namespace impulse_cover {
@@ -19,57 +41,276 @@ class OnOpenTrigger;
 class OnCloseTrigger;
 class OnIdleTrigger;
 class SafetyTrigger;
+class ImpulseCover;
+template<bool HAS_OPEN, bool HAS_CLOSE> struct EndstopReconciler;
+// Defined only by the host benchmarks, to call the protected hot path
+class HotPathAccess;
+
+// Told when a cover starts, restarts (a reversal or a press sent again) and
+// stops moving (impulse_cover_hub); runs poll() for polling covers while they move
+class LoopDriver {
+ public:
+  virtual void set_moving(ImpulseCover *cover, bool moving) = 0;
+  // A press just set the motor running, from rest or the other way
+  virtual void on_motor_start(ImpulseCover *cover) = 0;
+};
+
+enum MotionMode : uint8_t {
+  MOTION_MODE_POLLING = 0,  // position, target and safety checked on every loop()
+  MOTION_MODE_EVENT,        // stop and safety deadlines armed in the scheduler, loop() disabled
+};
+
+// Why a state publish is requested; publish_state_() applies the publish policy accordingly
+enum PublishReason : uint8_t {
+  PUBLISH_TRANSITION = 0,  // operation changed or position corrected: always published
+  PUBLISH_PROGRESS,        // periodic update while moving: rate, delta and transitions-only limits
+  PUBLISH_HEARTBEAT,       // forced refresh when nothing was published for a heartbeat period
+};
+
+// Deadlines of a cover, one handler each in on_timer_(). Scheduler timeouts
+// by default, fixed slots run from loop() with IMPULSE_COVER_ZERO_HEAP.
+enum TimerId : uint8_t {
+  TIMER_PULSE = 0,       // next relay step of the pulse sequence
+  TIMER_PULSE_DEFER,     // pulse held back to respect pulse_delay
+  TIMER_COMMAND_SETTLE,  // end of the command_settle window
+  TIMER_MOTION_TARGET,   // event mode: target deadline
+  TIMER_MOTION_SAFETY,   // event mode: safety timeout
+  TIMER_MOTION_PUBLISH,  // event mode: progress publish, periodic
+  TIMER_STATE_SAVE,      // save coalesced within min_save_interval
+  TIMER_PULSE_ACK,       // end of the window for the gate to show it started
+  TIMER_COUNT,
+};
+
+// Relays a pulse pattern can go out on
+enum PulseOutput : uint8_t {
+  PULSE_OUTPUT_IMPULSE = 0,  // output: the impulse input, cycled through the controller states
+  PULSE_OUTPUT_OPEN,         // open_output, close_output, stop_output: dedicated inputs, one press each
+  PULSE_OUTPUT_CLOSE,
+  PULSE_OUTPUT_STOP,
+  PULSE_OUTPUT_COUNT,
+};
+
+// Diagnostic values exposed through the impulse_cover sensor platform
+enum DiagnosticSensor : uint8_t {
+  DIAGNOSTIC_OPEN_STOP_LEAD = 0,
+  DIAGNOSTIC_CLOSE_STOP_LEAD,
+  DIAGNOSTIC_OPEN_DURATION,
+  DIAGNOSTIC_CLOSE_DURATION,
+  DIAGNOSTIC_STATE_SAVES,            // flash writes since boot
+  DIAGNOSTIC_STATE_SAVES_COALESCED,  // save requests absorbed since boot
+  DIAGNOSTIC_PULSES,
+  DIAGNOSTIC_DOUBLE_PULSES,
+  DIAGNOSTIC_DEFERRED_PULSES,
+  DIAGNOSTIC_SAFETY_TRIPS,
+  DIAGNOSTIC_CORRECTIONS,
+  DIAGNOSTIC_ENDSTOP_ARRIVALS,
+  DIAGNOSTIC_LOOP_TIME_P95,        // us
+  DIAGNOSTIC_COMMAND_LATENCY_P95,  // ms
+  DIAGNOSTIC_PULSE_JITTER_P95,     // ms
+  DIAGNOSTIC_ARRIVAL_ERROR_P95,    // ms
+  DIAGNOSTIC_COALESCED_COMMANDS,   // position commands superseded within command_settle
+  DIAGNOSTIC_ENDSTOP_DELAY_P95,    // ms
+  DIAGNOSTIC_MISSED_PRESSES,       // start presses the gate showed no motion after
+  DIAGNOSTIC_ACK_LATENCY_P95,      // ms
+  DIAGNOSTIC_SENSOR_COUNT,
+};
+
+// Values learned at runtime and kept across reboots
+struct LearnedState {
+  float open_stop_lead;   // ms between the stop pulse and the gate coming to rest
+  float close_stop_lead;
+  uint32_t open_duration;  // ms, endstop to endstop
+  uint32_t close_duration;
+};
 
 class ImpulseCover : public cover::Cover, public Component {
  public:
+  // Fixed storage, so nothing grows after codegen; cover.py keeps configs within it
+  static const uint8_t MAX_POSITION_MARKS = 8;
+  static const uint8_t MAX_TRIGGERS = 8;
+
   void setup() override;
   void loop() override;
+  // Motion and sensor checks of a polling cover: run by loop(), or by the hub while the cover moves
+  void poll();
   void dump_config() override;
+  void on_shutdown() override;
+  void on_safe_shutdown() override;
   
   // Configuration setters
   void set_open_duration(uint32_t duration) { this->open_duration_ = duration; }
   void set_close_duration(uint32_t duration) { this->close_duration_ = duration; }
   void set_pulse_delay(uint32_t delay) { this->pulse_delay_ = delay; }
+  // Appends a step to pattern; patterns left empty are built from pulse_delay in setup()
+  void add_pulse_step(PulsePattern pattern, bool press, uint32_t duration) {
+    this->pulse_sequencer_.add_step(pattern, press, duration);
+  }
+  void set_controller_profile(ControllerProfile profile) { this->controller_.set_profile(profile); }
   void set_safety_timeout(uint32_t timeout) { this->safety_timeout_ = timeout; }
   void set_safety_max_cycles(uint8_t cycles) { this->safety_max_cycles_ = cycles; }
+  void set_motion_mode(MotionMode mode) { this->motion_mode_ = mode; }
+  MotionMode get_motion_mode() const { return this->motion_mode_; }
+  void set_open_curve(TravelCurve *curve) { this->open_curve_ = curve; }
+  void set_close_curve(TravelCurve *curve) { this->close_curve_ = curve; }
+  void set_open_stop_lead(uint32_t lead) { this->open_stop_lead_ = lead; }
+  void set_close_stop_lead(uint32_t lead) { this->close_stop_lead_ = lead; }
+  void set_learn_stop_lead(bool learn) { this->learn_stop_lead_ = learn; }
+  void set_learn_durations(bool learn) { this->learn_durations_ = learn; }
+  void set_min_save_interval(uint32_t interval) { this->min_save_interval_ = interval; }
+  void set_publish_min_delta(float delta) { this->publish_min_delta_ = delta; }
+  void set_publish_min_interval(uint32_t interval) { this->publish_min_interval_ = interval; }
+  void set_publish_transitions_only(bool transitions_only) { this->publish_transitions_only_ = transitions_only; }
+  void set_publish_heartbeat(uint32_t heartbeat) { this->publish_heartbeat_ = heartbeat; }
+  void set_trace_size(uint16_t size) { this->trace_size_ = size; }
+  void set_command_settle(uint32_t settle) { this->command_settle_ = settle; }
+  void set_hub(LoopDriver *hub) { this->hub_ = hub; }
+  // 0 leaves start presses unconfirmed
+  void set_ack_timeout(uint32_t timeout) { this->ack_timeout_ = timeout; }
+  void set_ack_retries(uint8_t retries) { this->ack_retries_ = retries; }
+  
+  float get_open_stop_lead() const { return this->open_stop_lead_; }
+  float get_close_stop_lead() const { return this->close_stop_lead_; }
+  uint32_t get_open_duration() const { return this->open_duration_; }
+  uint32_t get_close_duration() const { return this->close_duration_; }
+  uint32_t get_state_saves() const { return this->state_saves_; }
+  uint32_t get_state_saves_coalesced() const { return this->state_saves_coalesced_; }
+  const EventTrace &get_trace() const { return this->event_trace_; }
+  const PerfStats &get_stats() const { return this->stats_; }
+
+  // Logs the event trace as hex lines for sim/impulse_cover_trace to decode or replay
+  void dump_trace();
   
   // Safety control
-  void reset_safety_mode() { this->safety_triggered_ = false; this->safety_cycle_count_ = 0; }
+  void reset_safety_mode() {
+    this->trace_(TRACE_COMMAND, TRACE_COMMAND_RESET_SAFETY, 0);
+    this->safety_triggered_ = false;
+    this->safety_cycle_count_ = 0;
+  }
   bool is_safety_triggered() const { return this->safety_triggered_; }
   
-  void set_output(output::BinaryOutput *output) { this->output_ = output; }
+  void set_output(output::BinaryOutput *output) { this->outputs_[PULSE_OUTPUT_IMPULSE] = output; }
+  void set_open_output(output::BinaryOutput *output) { this->outputs_[PULSE_OUTPUT_OPEN] = output; }
+  void set_close_output(output::BinaryOutput *output) { this->outputs_[PULSE_OUTPUT_CLOSE] = output; }
+  void set_stop_output(output::BinaryOutput *output) { this->outputs_[PULSE_OUTPUT_STOP] = output; }
 #ifdef USE_BINARY_SENSOR
   void set_open_sensor(binary_sensor::BinarySensor *sensor);
   void set_close_sensor(binary_sensor::BinarySensor *sensor);
-  void set_open_sensor_inverted(bool inverted) { this->open_sensor_inverted_ = inverted; }
-  void set_close_sensor_inverted(bool inverted) { this->close_sensor_inverted_ = inverted; }
+  // Direct endstop inputs, timestamped in their interrupt; the binary sensors still give the state
+  void set_open_sensor_pin(InternalGPIOPin *pin) { this->endstop_edges_[0].set_pin(pin); }
+  void set_close_sensor_pin(InternalGPIOPin *pin) { this->endstop_edges_[1].set_pin(pin); }
+  void set_endstop_debounce(uint32_t debounce) { this->endstop_debounce_ = debounce; }
+  // Reed switch or similar between the endstops that turns on with the gate at position
+  void add_position_mark(binary_sensor::BinarySensor *sensor, float position);
+#endif
+#ifdef USE_SENSOR
+  // Encoder or pulse counter total, counts_per_travel counts for a full run
+  void set_encoder(sensor::Sensor *sensor, float counts_per_travel);
+  // Motor current: motion start, the natural stop at the end, and stalls
+  void set_current_sensor(sensor::Sensor *sensor);
+  void set_current_threshold(float threshold) { this->current_monitor_.set_threshold(threshold); }
+  void set_current_start_time(uint32_t time) { this->current_monitor_.set_start_time(time); }
+  void set_current_stop_time(uint32_t time) { this->current_monitor_.set_stop_time(time); }
+  void set_stall_threshold(float threshold) { this->current_monitor_.set_stall_threshold(threshold); }
+  void set_stall_time(uint32_t time) { this->current_monitor_.set_stall_time(time); }
+  void set_diagnostic_sensor(DiagnosticSensor type, sensor::Sensor *sensor) {
+    this->diagnostic_sensors_[type] = sensor;
+  }
+  void set_eta_sensor(sensor::Sensor *sensor) { this->eta_sensor_ = sensor; }
+  void set_target_sensor(sensor::Sensor *sensor) { this->target_sensor_ = sensor; }
+#endif
+#ifdef USE_TEXT_SENSOR
+  void set_trajectory_text_sensor(text_sensor::TextSensor *sensor) { this->trajectory_text_sensor_ = sensor; }
 #endif
   
   // Override cover traits
   cover::CoverTraits get_traits() override;
 
  protected:
+  friend class HotPathAccess;
   void control(const cover::CoverCall &call) override;
   
   // Main control methods (inspired by feedback_cover)
   void start_direction_(cover::CoverOperation dir);
+  bool plan_pulses_(ControllerGoal goal, PulsePlan &plan, PulseOutput &output);
+  void plan_direct_(ControllerGoal goal, PulsePlan &plan) const;
+  PulseOutput direct_output_(ControllerGoal goal) const;
+  bool can_stop_() const {
+    return this->direct_output_(CONTROLLER_GOAL_STOP) != PULSE_OUTPUT_IMPULSE || this->controller_.can_stop();
+  }
+  void sync_controller_();
+  void move_to_(float pos);
+  void apply_queued_command_();
+  void cancel_queued_command_();
   void recompute_position_();
+  motion_t position_at_(uint32_t now) const;
+  uint32_t time_to_position_(motion_t target) const;
+  motion_t curve_time_(cover::CoverOperation dir, motion_t position) const;
+  motion_t curve_position_(cover::CoverOperation dir, motion_t time) const;
+  bool is_intermediate_target_() const { return this->target_position_ > 0 && this->target_position_ < MOTION_ONE; }
+  float stop_lead_(cover::CoverOperation dir) const {
+    return dir == cover::COVER_OPERATION_OPENING ? this->open_stop_lead_ : this->close_stop_lead_;
+  }
   bool is_at_target_() const;
   void set_current_operation_(cover::CoverOperation operation, bool is_triggered);
+  void anchor_move_(cover::CoverOperation operation);
+  motion_t lead_in_position_at_(uint32_t now) const;
+  motion_t travel_from_(ControllerState state, motion_t from, uint32_t elapsed) const;
+  void end_lead_in_();
+  void on_press_();
+  void fix_position_(motion_t position);
+  int8_t travel_direction_() const;
+  void publish_state_(PublishReason reason);
+  void publish_trajectory_();
+  void on_target_reached_();
+  void on_safety_timeout_();
+  void on_current_(float current);
+  void on_motor_stopped_(uint32_t stopped_at);
+  void on_stall_();
+  bool awaits_motor_stop_() const;
+  void expect_ack_(ControllerState before, uint32_t now);
+  bool can_ack_(bool stop) const;
+  void on_ack_(bool moving, uint32_t seen_at);
+  void on_ack_timeout_();
+  void cancel_ack_();
+  void arm_motion_timers_();
+  void arm_target_timer_();
+  void cancel_motion_timers_();
+  void arm_timer_(TimerId id, uint32_t delay, uint32_t period = 0);
+  void cancel_timer_(TimerId id);
+  void on_timer_(TimerId id);
   
+  void arrive_at_end_(bool open_endstop, uint32_t now);
+  void observe_stop_lead_(motion_t actual_rest);
+  void observe_duration_(cover::CoverOperation dir, uint32_t elapsed);
 #ifdef USE_BINARY_SENSOR
   void endstop_reached_(bool open_endstop);
+  uint32_t endstop_time_(bool open_endstop, uint32_t now);
+  bool at_endstop_(bool open_endstop);
 #endif
+  void save_learned_state_();
+  void request_save_();
+  void flush_saves_();
+  void publish_diagnostics_();
   
- private:
-  void send_pulse_();
-  void send_double_pulse_();
-  void send_pulse_internal_(bool double_pulse);
+ protected:
+  void init_pulse_patterns_();
+  void send_plan_(const PulsePlan &plan, PulseOutput output);
+  void cancel_pending_pulses_();
+  void send_pattern_(PulsePattern pattern, PulseOutput output);
+  void run_pulse_step_(const PulseStep *step);
+  void write_output_(bool state);
+  void trace_(TraceEvent event, uint8_t arg, uint16_t value);
+  char trace_sensor_flag_(bool open_endstop) const;
   void check_safety_();
+  // Gate starts a plan may take before check_safety_() trips
+  uint8_t starts_left_() const;
+  void trip_cycle_safety_(uint8_t cycles);
 #ifdef USE_BINARY_SENSOR
-  bool get_sensor_state_(binary_sensor::BinarySensor *sensor, bool inverted);
   void check_sensor_alignment_();
-  void update_position_from_sensors_(bool is_initialization);
+  // Fixed by the sensor topology, see TopologyCover
+  virtual void update_position_from_sensors_(bool is_initialization) = 0;
+  virtual bool endstop_active_(bool open_endstop) const = 0;
+  virtual bool sensor_inverted_(bool open_endstop) const = 0;
 #endif
   
   // Configuration
@@ -78,34 +319,147 @@ class ImpulseCover : public cover::Cover, public Component {
   uint32_t pulse_delay_{500};        // 500ms between pulses
   uint32_t safety_timeout_{60000};   // 1 minute safety timeout
   uint8_t safety_max_cycles_{5};     // Max cycles before safety trigger
+  MotionMode motion_mode_{MOTION_MODE_POLLING};
+  LoopDriver *hub_{nullptr};         // drives poll() while moving instead of the App
+  TravelCurve *open_curve_{nullptr};   // nullptr = constant speed
+  TravelCurve *close_curve_{nullptr};
+  float open_stop_lead_{0};  // ms, configured initial value, then learned
+  float close_stop_lead_{0};
+  bool learn_stop_lead_{false};
+  bool learn_durations_{false};
+  uint32_t configured_open_duration_{0};  // codegen values, bound for learned durations
+  uint32_t configured_close_duration_{0};
+  uint32_t min_save_interval_{60000};  // minimum time between two flash writes
+  float publish_min_delta_{0.0f};       // position change needed for a progress publish
+  uint32_t publish_min_interval_{1000};  // minimum time between progress publishes
+  uint32_t publish_heartbeat_{0};        // 0 = no heartbeat
+  bool publish_transitions_only_{false};
   
   // Hardware
-  output::BinaryOutput *output_{nullptr};
+  output::BinaryOutput *outputs_[PULSE_OUTPUT_COUNT]{};
 #ifdef USE_BINARY_SENSOR
   binary_sensor::BinarySensor *open_sensor_{nullptr};
   binary_sensor::BinarySensor *close_sensor_{nullptr};
-  bool open_sensor_inverted_{false};
-  bool close_sensor_inverted_{false};
+  EndstopEdge endstop_edges_[2];  // open, close
+  uint32_t endstop_debounce_{10};  // ms
+  motion_t mark_positions_[MAX_POSITION_MARKS];
+  uint8_t mark_count_{0};
+#endif
+#ifdef USE_SENSOR
+  sensor::Sensor *diagnostic_sensors_[DIAGNOSTIC_SENSOR_COUNT]{};
+  sensor::Sensor *eta_sensor_{nullptr};
+  sensor::Sensor *target_sensor_{nullptr};
+  sensor::Sensor *encoder_sensor_{nullptr};
+  sensor::Sensor *current_sensor_{nullptr};
 #endif
+#ifdef USE_TEXT_SENSOR
+  text_sensor::TextSensor *trajectory_text_sensor_{nullptr};
+#endif
+  PositionFeedback feedback_;
+  CurrentMonitor current_monitor_;
+  ESPPreferenceObject learned_pref_;
+  
+  // Persistence: state and learned values are written when the cover settles,
+  // only if they changed, and at most once per min_save_interval_
+  float saved_position_{-1.0f};  // position last written to rtc_, -1 if unknown
+  uint32_t last_save_time_{0};
+  uint32_t state_saves_{0};
+  uint32_t state_saves_coalesced_{0};
+  bool learned_dirty_{false};
+  bool has_saved_{false};
   
   // State tracking (similar to feedback_cover)
   cover::CoverOperation current_trigger_operation_{cover::COVER_OPERATION_IDLE};
   cover::CoverOperation last_operation_{cover::COVER_OPERATION_IDLE};
   uint32_t start_dir_time_{0};
-  uint32_t last_recompute_time_{0};
   uint32_t last_pulse_time_{0};
   uint32_t last_publish_time_{0};
+  float last_published_position_{-1.0f};
 #ifdef USE_BINARY_SENSOR
   uint32_t last_sensor_check_time_{0};
 #endif
   bool pulse_sent_{false};
+  PulseSequencer pulse_sequencer_;
+  uint32_t step_deadline_{0};                     // end of the pulse step in progress
+  uint16_t press_width_{0};                       // scheduled length of the last press, ms
+  PulsePattern deferred_pattern_{PULSE_SINGLE};   // pattern waiting on TIMER_PULSE_DEFER
+  PulseOutput deferred_output_{PULSE_OUTPUT_IMPULSE};
+  PulseOutput running_output_{PULSE_OUTPUT_IMPULSE};  // relay of the running sequence
+  bool pulse_queued_{false};                      // a pulse waits for the running sequence to end
+  PulsePlan plan_{};                              // patterns of the last plan
+  PulseOutput plan_output_{PULSE_OUTPUT_IMPULSE};
+  uint8_t plan_next_{0};                          // first of them not yet handed to send_pattern_()
+  ControllerFsm controller_;
+  
+  // Lead-in of a plan whose presses are not all out yet: until the one that
+  // reaches the goal, the gate follows the controller states the others pass through
+  bool lead_in_{false};
+  ControllerGoal lead_in_goal_{CONTROLLER_GOAL_STOP};
+  motion_t lead_in_position_{0};  // where the gate was at the last press
+  uint32_t lead_in_time_{0};
+  bool relay_closed_{false};
   bool safety_triggered_{false};
   uint8_t safety_cycle_count_{0};
   
-  // Position calculation
-  float target_position_{0};
+  // Press acknowledgement: a press that starts the gate is confirmed by the first sign of
+  // motion within ack_timeout_, one that stops it by the motor current dropping; else it is
+  // taken as missed and sent again, up to ack_retries_ times per command
+  uint32_t ack_timeout_{0};
+  uint8_t ack_retries_{2};
+  bool ack_pending_{false};
+  bool ack_stop_{false};  // the press was to stop the gate
+  uint32_t ack_press_time_{0};
+  ControllerState ack_state_{CONTROLLER_STOPPED_NEXT_OPEN};  // controller state before the press
+  motion_t ack_position_{0};                                 // where the gate stood
+  uint8_t ack_attempts_{0};                                  // retries of the current command
+  
+  // Position calculation: snapshot of the move taken in set_current_operation_()
+  motion_t target_position_{0};
+  float start_position_{0};
+  motion_t start_offset_{0};  // Curve time (fraction of travel duration) matching the position at anchor_time_
+  uint32_t anchor_time_{0};   // start of the move, or its last position fix
+  uint32_t move_duration_{0};  // full run at the speed of the move, timed by position fixes
+  motion_rate_t motion_rate_{0};  // Travel per ms of the current direction
   bool has_initial_state_{false};
   
+  // Run started by a single pulse sent right away, timed until it reaches the endstop
+  uint32_t run_start_{0};
+  cover::CoverOperation run_dir_{cover::COVER_OPERATION_IDLE};
+  bool run_from_endstop_{false};
+  
+  // Stop-lead learning: the estimated rest position after the last stop pulse,
+  // checked against the endstop arrival time of the run that follows
+  motion_t lead_rest_position_{0};
+  cover::CoverOperation lead_stop_dir_{cover::COVER_OPERATION_IDLE};
+  
+  // Duration learning: recent full-run times per direction (open, close) for outlier rejection
+  static const uint8_t DURATION_SAMPLES = 5;
+  uint32_t duration_samples_[2][DURATION_SAMPLES]{};
+  uint8_t duration_sample_count_[2]{};
+  
+  // Runtime counters and histograms
+  PerfStats stats_;
+  uint32_t command_time_{0};
+  bool command_pending_{false};  // control() ran, the next start_direction_() decides on a pulse
+  bool latency_pending_{false};  // command_time_ awaits the relay closing
+  uint32_t pulse_on_time_{0};
+  uint32_t predicted_arrival_{0};
+  cover::CoverOperation predicted_dir_{cover::COVER_OPERATION_IDLE};  // endstop predicted_arrival_ is for
+  
+  // Binary event trace, allocated in setup()
+  EventTrace event_trace_;
+  uint16_t trace_size_{64};
+  
+  // Position commands arriving within command_settle_ of the first one collapse into the
+  // last, so a slider drag becomes a single move planned once
+  uint32_t command_settle_{0};
+  float queued_position_{0.0f};
+  bool command_queued_{false};
+  
+#ifdef IMPULSE_COVER_ZERO_HEAP
+  TimerSlots<TIMER_COUNT> timers_;
+#endif
+  
   // Public accessors for triggers
  public:
   // Automation triggers  
@@ -115,17 +469,110 @@ class ImpulseCover : public cover::Cover, public Component {
   void add_on_safety_trigger(SafetyTrigger *trigger);
 
  protected:
-  // Helper methods for firing triggers
-  void fire_on_open_triggers_();
-  void fire_on_close_triggers_();
-  void fire_on_idle_triggers_();
-  void fire_on_safety_triggers_();
+  enum TriggerEvent : uint8_t {
+    TRIGGER_OPEN = 0,
+    TRIGGER_CLOSE,
+    TRIGGER_IDLE,
+    TRIGGER_SAFETY,
+  };
+  struct TriggerEntry {
+    TriggerEvent event;
+    Trigger<> *trigger;
+  };
+
+  void fire_triggers_(TriggerEvent event);
+
+  void add_trigger_(TriggerEvent event, Trigger<> *trigger);
+
+  // One fixed list for all events: most covers have no triggers or only on_safety
+  TriggerEntry triggers_[MAX_TRIGGERS];
+  uint8_t trigger_count_{0};
+
+#ifdef USE_BINARY_SENSOR
+  // Cases of update_position_from_sensors_(); the sensor topology calls only the
+  // ones it can read. Each returns true if it corrected the position.
+  template<bool HAS_OPEN, bool HAS_CLOSE> friend struct EndstopReconciler;
+  bool reconcile_at_end_(bool open_endstop, bool is_initialization);
+  bool reconcile_not_at_end_(bool open_sensor, bool is_initialization);
+  bool reconcile_between_(bool is_initialization);
+  bool reconcile_conflict_(bool is_initialization);
+  void reconcile_none_(bool is_initialization);
+  void apply_reconciliation_(bool position_updated, bool is_initialization);
+#endif
+};
+
+#ifdef USE_BINARY_SENSOR
+// Position checks against the endstops, one specialization per set of sensors;
+// a topology compiles only the cases its sensors can report
+template<bool HAS_OPEN, bool HAS_CLOSE> struct EndstopReconciler {
+  // Both sensors: at either end, between them, or both active
+  template<typename Cover> static bool reconcile(Cover &cover, bool is_initialization) {
+    const bool open = cover.endstop_active_(true);
+    const bool close = cover.endstop_active_(false);
+    if (open && close)
+      return cover.reconcile_conflict_(is_initialization);
+    if (open || close)
+      return cover.reconcile_at_end_(open, is_initialization);
+    return cover.reconcile_between_(is_initialization);
+  }
+};
+template<> struct EndstopReconciler<true, false> {
+  // One sensor: at its end, or anywhere else
+  template<typename Cover> static bool reconcile(Cover &cover, bool is_initialization) {
+    if (cover.endstop_active_(true))
+      return cover.reconcile_at_end_(true, is_initialization);
+    return cover.reconcile_not_at_end_(true, is_initialization);
+  }
+};
+template<> struct EndstopReconciler<false, true> {
+  template<typename Cover> static bool reconcile(Cover &cover, bool is_initialization) {
+    if (cover.endstop_active_(false))
+      return cover.reconcile_at_end_(false, is_initialization);
+    return cover.reconcile_not_at_end_(false, is_initialization);
+  }
+};
+template<> struct EndstopReconciler<false, false> {
+  template<typename Cover> static bool reconcile(Cover &cover, bool is_initialization) {
+    cover.reconcile_none_(is_initialization);
+    return false;
+  }
+};
+#endif
 
-  // Trigger lists
-  std::vector<Trigger<> *> on_open_triggers_;
-  std::vector<Trigger<> *> on_close_triggers_;
-  std::vector<Trigger<> *> on_idle_triggers_;
-  std::vector<SafetyTrigger *> on_safety_triggers_;
+// Endstop sensors of a cover as fixed by cover.py: which exist and which read inverted
+template<bool HAS_OPEN, bool HAS_CLOSE, bool OPEN_INVERTED = false, bool CLOSE_INVERTED = false>
+struct SensorTopology {
+  static const bool has_open = HAS_OPEN;
+  static const bool has_close = HAS_CLOSE;
+  static const bool open_inverted = OPEN_INVERTED;
+  static const bool close_inverted = CLOSE_INVERTED;
+#ifdef USE_BINARY_SENSOR
+  // Checks the cover's position against these sensors; true if it was corrected
+  template<typename Cover> static bool reconcile(Cover &cover, bool is_initialization) {
+    return EndstopReconciler<HAS_OPEN, HAS_CLOSE>::reconcile(cover, is_initialization);
+  }
+#endif
+};
+
+// The cover as generated for one sensor topology: endstop checks and the
+// position reconciliation compile to the configured sensors only, with the
+// inversions folded in
+template<typename Topology> class TopologyCover final : public ImpulseCover {
+#ifdef USE_BINARY_SENSOR
+ protected:
+  template<bool HAS_OPEN, bool HAS_CLOSE> friend struct EndstopReconciler;
+  void update_position_from_sensors_(bool is_initialization) override {
+    this->apply_reconciliation_(Topology::reconcile(*this, is_initialization), is_initialization);
+  }
+  bool endstop_active_(bool open_endstop) const override {
+    if (open_endstop)
+      return Topology::has_open && this->open_sensor_->state != Topology::open_inverted;
+    return Topology::has_close && this->close_sensor_->state != Topology::close_inverted;
+  }
+  bool sensor_inverted_(bool open_endstop) const override {
+    return open_endstop ? Topology::open_inverted : Topology::close_inverted;
+  }
+#endif
 };
 
 // Specific trigger classes to avoid ID conflicts
@@ -172,5 +619,15 @@ template<typename... Ts> class ResetSafetyAction : public Action<Ts...> {
   ImpulseCover *cover_;
 };
 
+template<typename... Ts> class DumpTraceAction : public Action<Ts...> {
+ public:
+  explicit DumpTraceAction(ImpulseCover *cover) : cover_(cover) {}
+
+  void play(Ts... x) override { this->cover_->dump_trace(); }
+
+ protected:
+  ImpulseCover *cover_;
+};
+
 }  // namespace impulse_cover
 }  // namespace esphome
\ No newline at end of file
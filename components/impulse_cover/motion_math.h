@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+namespace esphome {
+namespace impulse_cover {
+
+// Number type of the motion engine: positions and curve times as fractions of
+// a full run. With IMPULSE_COVER_FIXED_POINT they are integers in 1/65536
+// steps, so a target without an FPU (ESP8266) does no soft-float math while a
+// cover moves and position comparisons are exact. cover::Cover::position
+// stays a float and is written from the engine.
+#ifdef IMPULSE_COVER_FIXED_POINT
+using motion_t = uint32_t;
+using motion_rate_t = uint32_t;  // 1/65536 of the travel per ms, 16 fraction bits
+static const motion_t MOTION_ONE = 1u << 16;
+
+inline motion_t to_motion(float position) {
+  if (position <= 0.0f)
+    return 0;
+  return position >= 1.0f ? MOTION_ONE : static_cast<motion_t>(position * MOTION_ONE + 0.5f);
+}
+inline float from_motion(motion_t value) { return value * (1.0f / MOTION_ONE); }
+
+// Speed of a full run lasting duration_ms; the one division of a move
+inline motion_rate_t motion_rate(uint32_t duration_ms) {
+  return duration_ms > 1 ? static_cast<motion_rate_t>(((uint64_t(MOTION_ONE) << 16) + duration_ms / 2) / duration_ms)
+                          : UINT32_MAX;
+}
+// Share of a full run covered in elapsed_ms, rounded, at most one run
+inline motion_t motion_travel(uint32_t elapsed_ms, motion_rate_t rate) {
+  const uint64_t travel = (uint64_t(elapsed_ms) * rate + (1u << 15)) >> 16;
+  return travel < MOTION_ONE ? static_cast<motion_t>(travel) : MOTION_ONE;
+}
+// Milliseconds a full run of duration_ms needs to cover share, rounded up
+inline uint32_t motion_time(motion_t share, uint32_t duration_ms) {
+  return static_cast<uint32_t>((uint64_t(share) * duration_ms + MOTION_ONE - 1) >> 16);
+}
+#else
+using motion_t = float;
+using motion_rate_t = float;
+static const motion_t MOTION_ONE = 1.0f;
+
+inline motion_t to_motion(float position) { return position; }
+inline float from_motion(motion_t value) { return value; }
+
+inline motion_rate_t motion_rate(uint32_t duration_ms) { return 1.0f / duration_ms; }
+inline motion_t motion_travel(uint32_t elapsed_ms, motion_rate_t rate) {
+  const motion_t travel = elapsed_ms * rate;
+  return travel < MOTION_ONE ? travel : MOTION_ONE;
+}
+inline uint32_t motion_time(motion_t share, uint32_t duration_ms) {
+  return static_cast<uint32_t>(std::ceil(share * duration_ms));
+}
+#endif
+
+}  // namespace impulse_cover
+}  // namespace esphome
@@ -0,0 +1,27 @@
+#include "perf_stats.h"
+
+namespace esphome {
+namespace impulse_cover {
+
+const uint32_t LOOP_TIME_BOUNDS_US[Histogram::BUCKETS] = {10, 25, 50, 100, 250, 500, 1000, 5000};
+const uint32_t LATENCY_BOUNDS_MS[Histogram::BUCKETS] = {0, 5, 20, 50, 100, 250, 500, 1000};
+const uint32_t JITTER_BOUNDS_MS[Histogram::BUCKETS] = {0, 2, 5, 10, 20, 50, 100, 250};
+const uint32_t ARRIVAL_BOUNDS_MS[Histogram::BUCKETS] = {100, 250, 500, 1000, 2000, 4000, 8000, 16000};
+const uint32_t ENDSTOP_DELAY_BOUNDS_MS[Histogram::BUCKETS] = {2, 5, 10, 20, 50, 100, 250, 500};
+const uint32_t ACK_LATENCY_BOUNDS_MS[Histogram::BUCKETS] = {100, 200, 300, 500, 750, 1000, 2000, 5000};
+
+uint32_t Histogram::percentile(float p) const {
+  if (this->count_ == 0)
+    return 0;
+  const uint32_t rank = static_cast<uint32_t>(p * (this->count_ - 1)) + 1;
+  uint32_t seen = 0;
+  for (uint8_t i = 0; i < BUCKETS; i++) {
+    seen += this->counts_[i];
+    if (seen >= rank)
+      return this->bounds_[i] < this->max_ ? this->bounds_[i] : this->max_;
+  }
+  return this->max_;
+}
+
+}  // namespace impulse_cover
+}  // namespace esphome
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome {
+namespace impulse_cover {
+
+// Fixed-bucket histogram: BUCKETS upper bounds plus an overflow bucket.
+// Adding a sample is a short scan and an increment, cheap enough to stay on.
+class Histogram {
+ public:
+  static const uint8_t BUCKETS = 8;
+
+  explicit Histogram(const uint32_t *bounds) : bounds_(bounds) {}
+
+  void add(uint32_t value) {
+    uint8_t i = 0;
+    while (i < BUCKETS && value > this->bounds_[i])
+      i++;
+    this->counts_[i]++;
+    this->count_++;
+    if (value > this->max_)
+      this->max_ = value;
+  }
+
+  uint32_t count() const { return this->count_; }
+  uint32_t max() const { return this->max_; }
+  // Upper bound of the bucket holding the p-quantile; the maximum if that is the overflow bucket
+  uint32_t percentile(float p) const;
+
+ protected:
+  const uint32_t *bounds_;
+  uint32_t counts_[BUCKETS + 1]{};
+  uint32_t count_{0};
+  uint32_t max_{0};
+};
+
+// Bucket bounds
+extern const uint32_t LOOP_TIME_BOUNDS_US[Histogram::BUCKETS];
+extern const uint32_t LATENCY_BOUNDS_MS[Histogram::BUCKETS];
+extern const uint32_t JITTER_BOUNDS_MS[Histogram::BUCKETS];
+extern const uint32_t ARRIVAL_BOUNDS_MS[Histogram::BUCKETS];
+extern const uint32_t ENDSTOP_DELAY_BOUNDS_MS[Histogram::BUCKETS];
+extern const uint32_t ACK_LATENCY_BOUNDS_MS[Histogram::BUCKETS];
+
+// Always-on runtime counters, reported by dump_config() and the diagnostic sensors
+struct PerfStats {
+  uint32_t pulses{0};              // single pulses sent
+  uint32_t double_pulses{0};       // double pulses sent
+  uint32_t deferred_pulses{0};     // pulses postponed to respect pulse_delay
+  uint32_t safety_trips{0};
+  uint32_t corrections{0};         // position corrected from the endstop states
+  uint32_t endstop_arrivals{0};
+  uint32_t coalesced_commands{0};  // position commands superseded within command_settle
+  uint32_t missed_presses{0};      // start presses not followed by motion within ack_timeout
+  Histogram loop_time{LOOP_TIME_BOUNDS_US};          // loop() while moving, us
+  Histogram command_latency{LATENCY_BOUNDS_MS};      // control() to the relay closing, ms
+  Histogram pulse_jitter{JITTER_BOUNDS_MS};          // actual minus scheduled pulse width, ms
+  Histogram arrival_error{ARRIVAL_BOUNDS_MS};        // endstop arrival vs predicted time, ms
+  Histogram endstop_delay{ENDSTOP_DELAY_BOUNDS_MS};  // interrupt edge to sensor callback, ms
+  Histogram ack_latency{ACK_LATENCY_BOUNDS_MS};      // start press to the first sign of motion, ms
+};
+
+}  // namespace impulse_cover
+}  // namespace esphome
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include "motion_math.h"
+
+namespace esphome {
+namespace impulse_cover {
+
+// Fixes of the gate position between the endstops, from reed switches at known
+// positions or an encoder, and the speed they imply. The owner re-anchors the
+// time-based estimate on every fix; the fixes of a move also give it the
+// duration of a full run at the speed the gate actually has.
+class PositionFeedback {
+ public:
+  // Fixes this far apart on the curve time of a move time its speed
+  static constexpr float MIN_SPAN = 0.05f;
+
+  // A move started: fixes of earlier moves say nothing about its speed
+  void start_move() { this->has_fix_ = false; }
+  // Fix at now, at curve time of the move's direction; returns the full-run
+  // duration the fixes of the move imply, 0 while they span too little
+  uint32_t fix(uint32_t now, motion_t curve_time) {
+    if (!this->has_fix_) {
+      this->has_fix_ = true;
+      this->first_time_ = now;
+      this->first_curve_time_ = curve_time;
+      return 0;
+    }
+    if (curve_time < this->first_curve_time_ + to_motion(MIN_SPAN))
+      return 0;
+    const float span = from_motion(curve_time - this->first_curve_time_);
+    return static_cast<uint32_t>((now - this->first_time_) / span + 0.5f);
+  }
+
+  // Encoder with counts_per_travel counts for a full run; 0 for none
+  void set_counts_per_travel(float counts) { this->counts_per_travel_ = counts; }
+  float get_counts_per_travel() const { return this->counts_per_travel_; }
+  // The gate is known to be at position, whatever the encoder counted so far
+  void rebase(motion_t position) { this->encoder_position_ = position; }
+  motion_t get_encoder_position() const { return this->encoder_position_; }
+  // A reading of the encoder: the counts since the previous one are travel in
+  // the direction given, +1 opening, -1 closing, 0 unknown (not counted). A
+  // quadrature encoder's sign is not used. False if nothing moved.
+  bool count(float reading, int8_t direction) {
+    const float counts = this->has_reading_ ? std::fabs(reading - this->last_reading_) : 0.0f;
+    this->has_reading_ = true;
+    this->last_reading_ = reading;
+    if (counts == 0.0f || direction == 0)
+      return false;
+    const motion_t travel = to_motion(std::fmin(counts / this->counts_per_travel_, 1.0f));
+    if (direction > 0) {
+      this->encoder_position_ = travel < MOTION_ONE - this->encoder_position_ ? this->encoder_position_ + travel
+                                                                              : MOTION_ONE;
+    } else {
+      this->encoder_position_ = travel < this->encoder_position_ ? this->encoder_position_ - travel : 0;
+    }
+    return true;
+  }
+
+ protected:
+  bool has_fix_{false};
+  uint32_t first_time_{0};
+  motion_t first_curve_time_{0};
+  float counts_per_travel_{0.0f};
+  bool has_reading_{false};
+  float last_reading_{0.0f};
+  motion_t encoder_position_{0};
+};
+
+}  // namespace impulse_cover
+}  // namespace esphome
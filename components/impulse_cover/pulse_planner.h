@@ -0,0 +1,216 @@
+#pragma once
+
+#include <cstdint>
+
+#include "controller_fsm.h"
+#include "motion_math.h"
+#include "pulse_sequencer.h"
+
+namespace esphome {
+namespace impulse_cover {
+
+// Where the cover stands when a command is planned, times in ms from now
+struct PlanRequest {
+  ControllerState state;   // tracked controller state
+  ControllerGoal goal;
+  motion_t position;       // gate position
+  motion_t target;         // where an open or close goal heads for
+  bool running;            // a pattern is on the relay
+  uint32_t step_left;      // until the step in progress ends
+  uint32_t gap_left;       // until pulse_delay has passed since the last pattern started
+  uint8_t budget;          // gate starts left before the safety trip
+};
+
+// Patterns to send one after the other, pulse_delay apart, and what they cost
+struct PulsePlan {
+  PulsePattern patterns[ControllerFsm::MAX_PRESSES];
+  uint8_t count;     // patterns
+  uint8_t presses;
+  uint8_t starts;    // presses that start or reverse the gate
+  bool cut;          // the running pattern is cut short after the step in progress
+  bool near_end;     // a press comes about when a run is due at an end: it may find the gate either way
+  uint32_t lead;     // until the press that reaches the goal
+  uint32_t time;     // until the target, or until the stop press for a stop
+  motion_t from;     // where the gate is at the press that reaches the goal
+};
+
+// Searches the ways to reach a controller goal and picks the one that gets
+// there first. A way is the running pattern either finished or cut short,
+// followed by the fewest presses to the goal, sent as doubles and singles in
+// any split; a single that brings the gate to rest is the stop pattern. The
+// gate is taken to move at constant speed in whichever direction each press
+// leaves the controller, and to stop at an end it runs into. Plans over the
+// safety budget lose to any plan within it, then plans that press about when
+// a run is due at an end lose to those that do not.
+class PulsePlanner {
+ public:
+  // Either side of a run's predicted arrival at an end, the gate may or may not be there
+  static const uint32_t END_MARGIN = 500;
+
+  PulsePlanner(const ControllerFsm &fsm, const PulseSequencer &sequencer, uint32_t pulse_delay,
+               uint32_t open_duration, uint32_t close_duration)
+      : fsm_(fsm),
+        sequencer_(sequencer),
+        pulse_delay_(pulse_delay),
+        open_duration_(open_duration),
+        close_duration_(close_duration) {}
+
+  // Number of ways considered, 0 if the goal is out of reach; best gets the fastest
+  uint8_t plan(const PlanRequest &request, PulsePlan &best) const {
+    uint8_t options = 0;
+    for (uint8_t cut = 0; cut < 2; cut++) {
+      if (cut && this->sequencer_.remaining_steps() == 0)
+        continue;
+      // A double is two neighbouring presses: bit i joins press i to press i + 1
+      for (uint8_t doubles = 0; doubles < (1u << (ControllerFsm::MAX_PRESSES - 1)); doubles++) {
+        if (doubles & (doubles >> 1))
+          continue;
+        PulsePlan plan{};
+        if (!this->simulate_(request, cut, doubles, plan))
+          continue;
+        options++;
+        if (options == 1 || this->better_(plan, best, request.budget))
+          best = plan;
+      }
+    }
+    return options;
+  }
+
+ protected:
+  // Gate and controller through the presses of one way, in time order
+  struct Track {
+    ControllerState state;
+    motion_t position;
+    uint32_t time;
+    ControllerGoal goal;
+    uint32_t goal_time;      // last press that left the controller at the goal
+    motion_t goal_position;
+    bool near_end;
+  };
+
+  void press_at_(Track &track, uint32_t time) const {
+    if (track.state == CONTROLLER_OPENING || track.state == CONTROLLER_CLOSING) {
+      const bool opening = track.state == CONTROLLER_OPENING;
+      const motion_t to_end = opening ? MOTION_ONE - track.position : track.position;
+      const uint32_t arrival = track.time + motion_time(to_end, opening ? this->open_duration_ : this->close_duration_);
+      track.near_end |= (time > arrival ? time - arrival : arrival - time) < END_MARGIN;
+    }
+    track.position = this->travel_(track.state, track.position, time - track.time);
+    track.time = time;
+    // A run that reached an end stopped the controller there, as its limit does
+    if ((track.state == CONTROLLER_OPENING && track.position == MOTION_ONE) ||
+        (track.state == CONTROLLER_CLOSING && track.position == 0))
+      track.state = ControllerFsm::end_state(track.state == CONTROLLER_OPENING);
+    track.state = this->fsm_.after(track.state, 1);
+    if (ControllerFsm::reaches(track.state, track.goal)) {
+      track.goal_time = time;
+      track.goal_position = track.position;
+    }
+  }
+
+  motion_t travel_(ControllerState state, motion_t from, uint32_t elapsed) const {
+    if (state == CONTROLLER_OPENING) {
+      const motion_t travel = motion_travel(elapsed, motion_rate(this->open_duration_));
+      return travel < MOTION_ONE - from ? from + travel : MOTION_ONE;
+    }
+    if (state == CONTROLLER_CLOSING) {
+      const motion_t travel = motion_travel(elapsed, motion_rate(this->close_duration_));
+      return travel < from ? from - travel : 0;
+    }
+    return from;
+  }
+
+  // Presses of pattern from start, returning when it ends
+  uint32_t run_pattern_(Track &track, PulsePattern pattern, uint32_t start) const {
+    uint32_t time = start;
+    for (uint8_t i = 0; i < this->sequencer_.get_step_count(pattern); i++) {
+      const PulseStep &step = this->sequencer_.get_step(pattern, i);
+      if (step.press)
+        this->press_at_(track, time);
+      time += step.duration;
+    }
+    return time;
+  }
+
+  bool simulate_(const PlanRequest &request, bool cut, uint8_t doubles, PulsePlan &plan) const {
+    Track track{request.state, request.position, 0, request.goal, 0, request.position, false};
+    plan.cut = cut;
+
+    // The relay is free pulse_delay after the running pattern ends, or after the step in progress if cut
+    uint32_t time = request.gap_left;
+    if (request.running) {
+      time = request.step_left;
+      for (uint8_t i = 0; !cut && i < this->sequencer_.remaining_steps(); i++) {
+        const PulseStep &step = this->sequencer_.get_remaining_step(i);
+        if (step.press)
+          this->press_at_(track, time);
+        time += step.duration;
+      }
+      time += this->pulse_delay_;
+    }
+
+    // The fewest presses to the goal, counted again after each pattern: a run that
+    // reaches an end on the way leaves the controller at rest there
+    uint8_t presses = 0;
+    while (!ControllerFsm::reaches(track.state, request.goal)) {
+      const uint8_t needed = this->fsm_.presses_to(track.state, request.goal);
+      if (needed == ControllerFsm::UNREACHABLE || presses + needed > ControllerFsm::MAX_PRESSES)
+        return false;
+      PulsePattern pattern = PULSE_SINGLE;
+      if (doubles & (1u << presses)) {
+        // The second press of a double would take the gate past the goal
+        if (needed < 2)
+          return false;
+        pattern = PULSE_DOUBLE;
+      } else if (!ControllerFsm::reaches(track.state, CONTROLLER_GOAL_STOP) &&
+                 ControllerFsm::reaches(this->fsm_.after(track.state, 1), CONTROLLER_GOAL_STOP)) {
+        // A press of its own that brings the gate to rest is the stop pattern
+        pattern = PULSE_STOP;
+      }
+      const uint8_t count = pattern == PULSE_DOUBLE ? 2 : 1;
+      plan.starts += this->fsm_.starts(track.state, count);
+      plan.patterns[plan.count++] = pattern;
+      presses += count;
+      time = this->run_pattern_(track, pattern, time) + this->pulse_delay_;
+    }
+    // Joins past the last press would only repeat another split
+    if (doubles >> presses)
+      return false;
+    plan.presses = presses;
+    plan.near_end = track.near_end;
+
+    // From the press that reaches the goal the gate heads for the target at constant speed
+    plan.lead = track.goal_time;
+    plan.from = track.goal_position;
+    plan.time = plan.lead;
+    if (request.goal == CONTROLLER_GOAL_OPEN && request.target > plan.from) {
+      plan.time += motion_time(request.target - plan.from, this->open_duration_);
+    } else if (request.goal == CONTROLLER_GOAL_CLOSE && request.target < plan.from) {
+      plan.time += motion_time(plan.from - request.target, this->close_duration_);
+    }
+    return true;
+  }
+
+  static bool better_(const PulsePlan &a, const PulsePlan &b, uint8_t budget) {
+    const bool a_over = a.starts > budget;
+    const bool b_over = b.starts > budget;
+    if (a_over != b_over)
+      return !a_over;
+    if (a.near_end != b.near_end)
+      return !a.near_end;
+    if (a.time != b.time)
+      return a.time < b.time;
+    if (a.presses != b.presses)
+      return a.presses < b.presses;
+    return a.count < b.count;
+  }
+
+  const ControllerFsm &fsm_;
+  const PulseSequencer &sequencer_;
+  uint32_t pulse_delay_;
+  uint32_t open_duration_;
+  uint32_t close_duration_;
+};
+
+}  // namespace impulse_cover
+}  // namespace esphome
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome {
+namespace impulse_cover {
+
+// Relay patterns the cover sends; each is a short list of steps set from YAML
+enum PulsePattern : uint8_t {
+  PULSE_SINGLE = 0,  // one press: start, or advance the controller by one state
+  PULSE_DOUBLE,      // two presses: restart in the direction last driven
+  PULSE_STOP,        // stop a moving gate
+  PULSE_PATTERN_COUNT,
+};
+
+// One step of a pattern: relay level and how long it is held
+struct PulseStep {
+  uint16_t press : 1;
+  uint16_t duration : 15;  // ms, up to 32.7 s
+};
+
+// Fixed-size pattern table and the position in the sequence running from it.
+// The owner writes the level of each step returned by start() / next() and
+// arms one timer for its duration; the relay opens after the last step.
+class PulseSequencer {
+ public:
+  static const uint8_t MAX_STEPS = 8;
+  static const uint16_t MAX_DURATION = 0x7FFF;
+
+  bool add_step(PulsePattern pattern, bool press, uint32_t duration) {
+    uint8_t &count = this->counts_[pattern];
+    if (count >= MAX_STEPS || duration == 0 || duration > MAX_DURATION)
+      return false;
+    this->patterns_[pattern][count++] = {press, static_cast<uint16_t>(duration)};
+    return true;
+  }
+  uint8_t get_step_count(PulsePattern pattern) const { return this->counts_[pattern]; }
+  const PulseStep &get_step(PulsePattern pattern, uint8_t i) const { return this->patterns_[pattern][i]; }
+  // Sum of the step durations
+  uint32_t get_duration(PulsePattern pattern) const {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < this->counts_[pattern]; i++)
+      total += this->patterns_[pattern][i].duration;
+    return total;
+  }
+
+  // First step of pattern, replacing whatever ran before; nullptr for an empty pattern
+  const PulseStep *start(PulsePattern pattern) {
+    this->running_ = pattern;
+    this->next_ = 0;
+    this->end_ = this->counts_[pattern];
+    this->active_ = true;
+    return this->next();
+  }
+  // Following step, or nullptr once the sequence is done
+  const PulseStep *next() {
+    if (this->next_ >= this->end_) {
+      this->active_ = false;
+      return nullptr;
+    }
+    return &this->patterns_[this->running_][this->next_++];
+  }
+  // From start() until next() returns nullptr
+  bool is_running() const { return this->active_; }
+  // Steps still to come after the step in progress
+  uint8_t remaining_steps() const { return this->active_ ? this->end_ - this->next_ : 0; }
+  const PulseStep &get_remaining_step(uint8_t i) const { return this->patterns_[this->running_][this->next_ + i]; }
+  // The step in progress becomes the last one, so a press is never cut short
+  void truncate() { this->end_ = this->next_; }
+
+ protected:
+  PulseStep patterns_[PULSE_PATTERN_COUNT][MAX_STEPS]{};
+  uint8_t counts_[PULSE_PATTERN_COUNT]{};
+  PulsePattern running_{PULSE_SINGLE};
+  uint8_t next_{0};
+  uint8_t end_{0};
+  bool active_{false};
+};
+
+}  // namespace impulse_cover
+}  // namespace esphome
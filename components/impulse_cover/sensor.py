@@ -0,0 +1,152 @@
+import esphome.codegen as cg
+from esphome.components import sensor
+import esphome.config_validation as cv
+from esphome.const import (
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    ICON_COUNTER,
+    ICON_TIMER,
+    STATE_CLASS_MEASUREMENT,
+    STATE_CLASS_TOTAL_INCREASING,
+    UNIT_MICROSECOND,
+    UNIT_MILLISECOND,
+    UNIT_PERCENT,
+    UNIT_SECOND,
+)
+
+from .cover import ImpulseCover, impulse_cover_ns
+
+CONF_IMPULSE_COVER_ID = "impulse_cover_id"
+CONF_OPEN_STOP_LEAD = "open_stop_lead"
+CONF_CLOSE_STOP_LEAD = "close_stop_lead"
+CONF_OPEN_DURATION = "open_duration"
+CONF_CLOSE_DURATION = "close_duration"
+CONF_STATE_SAVES = "state_saves"
+CONF_STATE_SAVES_COALESCED = "state_saves_coalesced"
+CONF_PULSES = "pulses"
+CONF_DOUBLE_PULSES = "double_pulses"
+CONF_DEFERRED_PULSES = "deferred_pulses"
+CONF_SAFETY_TRIPS = "safety_trips"
+CONF_CORRECTIONS = "corrections"
+CONF_ENDSTOP_ARRIVALS = "endstop_arrivals"
+CONF_LOOP_TIME = "loop_time"
+CONF_COMMAND_LATENCY = "command_latency"
+CONF_PULSE_JITTER = "pulse_jitter"
+CONF_ARRIVAL_ERROR = "arrival_error"
+CONF_COALESCED_COMMANDS = "coalesced_commands"
+CONF_ENDSTOP_DELAY = "endstop_delay"
+CONF_MISSED_PRESSES = "missed_presses"
+CONF_ACK_LATENCY = "ack_latency"
+CONF_ETA = "eta"
+CONF_TARGET_POSITION = "target_position"
+
+DiagnosticSensor = impulse_cover_ns.enum("DiagnosticSensor")
+
+# Diagnostic values published by the cover, keyed by configuration name
+DIAGNOSTIC_SENSORS = {
+    CONF_OPEN_STOP_LEAD: DiagnosticSensor.DIAGNOSTIC_OPEN_STOP_LEAD,
+    CONF_CLOSE_STOP_LEAD: DiagnosticSensor.DIAGNOSTIC_CLOSE_STOP_LEAD,
+    CONF_OPEN_DURATION: DiagnosticSensor.DIAGNOSTIC_OPEN_DURATION,
+    CONF_CLOSE_DURATION: DiagnosticSensor.DIAGNOSTIC_CLOSE_DURATION,
+    CONF_STATE_SAVES: DiagnosticSensor.DIAGNOSTIC_STATE_SAVES,
+    CONF_STATE_SAVES_COALESCED: DiagnosticSensor.DIAGNOSTIC_STATE_SAVES_COALESCED,
+    CONF_PULSES: DiagnosticSensor.DIAGNOSTIC_PULSES,
+    CONF_DOUBLE_PULSES: DiagnosticSensor.DIAGNOSTIC_DOUBLE_PULSES,
+    CONF_DEFERRED_PULSES: DiagnosticSensor.DIAGNOSTIC_DEFERRED_PULSES,
+    CONF_SAFETY_TRIPS: DiagnosticSensor.DIAGNOSTIC_SAFETY_TRIPS,
+    CONF_CORRECTIONS: DiagnosticSensor.DIAGNOSTIC_CORRECTIONS,
+    CONF_ENDSTOP_ARRIVALS: DiagnosticSensor.DIAGNOSTIC_ENDSTOP_ARRIVALS,
+    CONF_LOOP_TIME: DiagnosticSensor.DIAGNOSTIC_LOOP_TIME_P95,
+    CONF_COMMAND_LATENCY: DiagnosticSensor.DIAGNOSTIC_COMMAND_LATENCY_P95,
+    CONF_PULSE_JITTER: DiagnosticSensor.DIAGNOSTIC_PULSE_JITTER_P95,
+    CONF_ARRIVAL_ERROR: DiagnosticSensor.DIAGNOSTIC_ARRIVAL_ERROR_P95,
+    CONF_COALESCED_COMMANDS: DiagnosticSensor.DIAGNOSTIC_COALESCED_COMMANDS,
+    CONF_ENDSTOP_DELAY: DiagnosticSensor.DIAGNOSTIC_ENDSTOP_DELAY_P95,
+    CONF_MISSED_PRESSES: DiagnosticSensor.DIAGNOSTIC_MISSED_PRESSES,
+    CONF_ACK_LATENCY: DiagnosticSensor.DIAGNOSTIC_ACK_LATENCY_P95,
+}
+
+STOP_LEAD_SCHEMA = sensor.sensor_schema(
+    unit_of_measurement=UNIT_MILLISECOND,
+    icon=ICON_TIMER,
+    accuracy_decimals=0,
+    state_class=STATE_CLASS_MEASUREMENT,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+)
+
+DURATION_SCHEMA = sensor.sensor_schema(
+    unit_of_measurement=UNIT_SECOND,
+    icon=ICON_TIMER,
+    accuracy_decimals=2,
+    state_class=STATE_CLASS_MEASUREMENT,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+)
+
+# Counted since boot
+COUNT_SCHEMA = sensor.sensor_schema(
+    icon=ICON_COUNTER,
+    accuracy_decimals=0,
+    state_class=STATE_CLASS_TOTAL_INCREASING,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+)
+
+# 95th percentile of a histogram kept since boot, published at the end of each move
+def percentile_schema(unit):
+    return sensor.sensor_schema(
+        unit_of_measurement=unit,
+        icon=ICON_TIMER,
+        accuracy_decimals=0,
+        state_class=STATE_CLASS_MEASUREMENT,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+    )
+
+
+CONFIG_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(CONF_IMPULSE_COVER_ID): cv.use_id(ImpulseCover),
+        cv.Optional(CONF_OPEN_STOP_LEAD): STOP_LEAD_SCHEMA,
+        cv.Optional(CONF_CLOSE_STOP_LEAD): STOP_LEAD_SCHEMA,
+        cv.Optional(CONF_OPEN_DURATION): DURATION_SCHEMA,
+        cv.Optional(CONF_CLOSE_DURATION): DURATION_SCHEMA,
+        cv.Optional(CONF_STATE_SAVES): COUNT_SCHEMA,
+        cv.Optional(CONF_STATE_SAVES_COALESCED): COUNT_SCHEMA,
+        cv.Optional(CONF_PULSES): COUNT_SCHEMA,
+        cv.Optional(CONF_DOUBLE_PULSES): COUNT_SCHEMA,
+        cv.Optional(CONF_DEFERRED_PULSES): COUNT_SCHEMA,
+        cv.Optional(CONF_SAFETY_TRIPS): COUNT_SCHEMA,
+        cv.Optional(CONF_CORRECTIONS): COUNT_SCHEMA,
+        cv.Optional(CONF_ENDSTOP_ARRIVALS): COUNT_SCHEMA,
+        cv.Optional(CONF_LOOP_TIME): percentile_schema(UNIT_MICROSECOND),
+        cv.Optional(CONF_COMMAND_LATENCY): percentile_schema(UNIT_MILLISECOND),
+        cv.Optional(CONF_PULSE_JITTER): percentile_schema(UNIT_MILLISECOND),
+        cv.Optional(CONF_ARRIVAL_ERROR): percentile_schema(UNIT_MILLISECOND),
+        cv.Optional(CONF_COALESCED_COMMANDS): COUNT_SCHEMA,
+        cv.Optional(CONF_ENDSTOP_DELAY): percentile_schema(UNIT_MILLISECOND),
+        cv.Optional(CONF_MISSED_PRESSES): COUNT_SCHEMA,
+        cv.Optional(CONF_ACK_LATENCY): percentile_schema(UNIT_MILLISECOND),
+        # Published once per transition, see the trajectory text sensor
+        cv.Optional(CONF_ETA): sensor.sensor_schema(
+            unit_of_measurement=UNIT_SECOND,
+            icon=ICON_TIMER,
+            accuracy_decimals=1,
+        ),
+        cv.Optional(CONF_TARGET_POSITION): sensor.sensor_schema(
+            unit_of_measurement=UNIT_PERCENT,
+            icon="mdi:target",
+            accuracy_decimals=0,
+        ),
+    }
+)
+
+
+async def to_code(config):
+    parent = await cg.get_variable(config[CONF_IMPULSE_COVER_ID])
+    for key, diagnostic in DIAGNOSTIC_SENSORS.items():
+        if key in config:
+            sens = await sensor.new_sensor(config[key])
+            cg.add(parent.set_diagnostic_sensor(diagnostic, sens))
+    if CONF_ETA in config:
+        sens = await sensor.new_sensor(config[CONF_ETA])
+        cg.add(parent.set_eta_sensor(sens))
+    if CONF_TARGET_POSITION in config:
+        sens = await sensor.new_sensor(config[CONF_TARGET_POSITION])
+        cg.add(parent.set_target_sensor(sens))
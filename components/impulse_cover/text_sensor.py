@@ -0,0 +1,44 @@
+import esphome.codegen as cg
+from esphome.components import text_sensor
+import esphome.config_validation as cv
+import esphome.final_validate as fv
+
+from .cover import CONF_ZERO_HEAP, ImpulseCover
+from .sensor import CONF_IMPULSE_COVER_ID
+
+CONF_TRAJECTORY = "trajectory"
+
+CONFIG_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(CONF_IMPULSE_COVER_ID): cv.use_id(ImpulseCover),
+        # JSON move description published once per transition
+        cv.Optional(CONF_TRAJECTORY): text_sensor.text_sensor_schema(
+            icon="mdi:chart-bell-curve-cumulative",
+        ),
+    }
+)
+
+
+def final_validate_trajectory(config):
+    # Text sensors hold their value in heap strings, reallocated on every publish
+    if CONF_TRAJECTORY not in config:
+        return config
+    full_config = fv.full_config.get()
+    cover_path = full_config.get_path_for_id(config[CONF_IMPULSE_COVER_ID])[:-1]
+    if full_config.get_config_for_path(cover_path).get(CONF_ZERO_HEAP):
+        raise cv.Invalid(
+            "the trajectory text sensor allocates on every publish and is not available "
+            "with zero_heap; use the eta and target_position sensors",
+            path=[CONF_TRAJECTORY],
+        )
+    return config
+
+
+FINAL_VALIDATE_SCHEMA = final_validate_trajectory
+
+
+async def to_code(config):
+    parent = await cg.get_variable(config[CONF_IMPULSE_COVER_ID])
+    if CONF_TRAJECTORY in config:
+        sens = await text_sensor.new_text_sensor(config[CONF_TRAJECTORY])
+        cg.add(parent.set_trajectory_text_sensor(sens))
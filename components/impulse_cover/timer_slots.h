@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome {
+namespace impulse_cover {
+
+// Fixed set of deadlines addressed by small integer ids, for the zero-heap
+// mode: arming, re-arming and cancelling never allocate. The owner runs
+// pop_due() from its loop() while any() is true.
+template<uint8_t N> class TimerSlots {
+  static_assert(N <= 16, "armed_ is a 16 bit mask");
+
+ public:
+  // Due delay ms after now; with a period, again every period ms (set_interval() semantics)
+  void set(uint8_t id, uint32_t now, uint32_t delay, uint32_t period = 0) {
+    this->slots_[id] = {now + delay, period};
+    this->armed_ |= 1u << id;
+  }
+  void cancel(uint8_t id) { this->armed_ &= ~(1u << id); }
+  bool any() const { return this->armed_ != 0; }
+
+  // Earliest slot due at now, or -1. One-shot slots are disarmed; periodic
+  // ones move on by their period, or to now + period if that is behind too.
+  int8_t pop_due(uint32_t now) {
+    if (this->armed_ == 0)
+      return -1;
+    int8_t due = -1;
+    uint32_t most_late = 0;
+    for (uint8_t id = 0; id < N; id++) {
+      if (!(this->armed_ & (1u << id)))
+        continue;
+      const uint32_t late = now - this->slots_[id].deadline;
+      if (static_cast<int32_t>(late) >= 0 && (due < 0 || late > most_late)) {
+        due = id;
+        most_late = late;
+      }
+    }
+    if (due < 0)
+      return -1;
+    Slot &slot = this->slots_[due];
+    if (slot.period == 0) {
+      this->armed_ &= ~(1u << due);
+    } else {
+      slot.deadline += slot.period;
+      if (static_cast<int32_t>(now - slot.deadline) >= 0)
+        slot.deadline = now + slot.period;
+    }
+    return due;
+  }
+
+ protected:
+  struct Slot {
+    uint32_t deadline;
+    uint32_t period;
+  };
+  Slot slots_[N]{};
+  uint16_t armed_{0};
+};
+
+}  // namespace impulse_cover
+}  // namespace esphome
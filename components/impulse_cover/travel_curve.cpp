@@ -0,0 +1,112 @@
+#include "travel_curve.h"
+#include "esphome/core/log.h"
+#include <algorithm>
+
+namespace esphome {
+namespace impulse_cover {
+
+static const char *const TAG = "impulse_cover.curve";
+
+void TravelCurve::add_point(float time, float progress) { this->points_.push_back({time, progress}); }
+
+void TravelCurve::set_phases(float accel, float decel) {
+  this->accel_ = accel;
+  this->decel_ = decel;
+}
+
+float TravelCurve::evaluate_(float time) const {
+  if (!this->points_.empty()) {
+    Point prev{0.0f, 0.0f};
+    for (const auto &point : this->points_) {
+      if (time <= point.time) {
+        const float span = point.time - prev.time;
+        return span > 0.0f ? prev.progress + (point.progress - prev.progress) * (time - prev.time) / span
+                           : point.progress;
+      }
+      prev = point;
+    }
+    const float span = 1.0f - prev.time;
+    return span > 0.0f ? prev.progress + (1.0f - prev.progress) * (time - prev.time) / span : 1.0f;
+  }
+
+  // Trapezoid: peak speed chosen so the full run covers exactly the travel
+  const float a = this->accel_;
+  const float d = this->decel_;
+  const float peak = 1.0f / (1.0f - a / 2.0f - d / 2.0f);
+  if (a > 0.0f && time < a) {
+    return peak * time * time / (2.0f * a);
+  }
+  if (d > 0.0f && time > 1.0f - d) {
+    const float left = 1.0f - time;
+    return 1.0f - peak * left * left / (2.0f * d);
+  }
+  return peak * (a / 2.0f + (time - a));
+}
+
+void TravelCurve::setup() {
+  std::sort(this->points_.begin(), this->points_.end(),
+            [](const Point &a, const Point &b) { return a.time < b.time; });
+
+  float last = 0.0f;
+  for (uint8_t i = 0; i <= LUT_SEGMENTS; i++) {
+    last = std::max(last, std::min(1.0f, this->evaluate_(float(i) / LUT_SEGMENTS)));
+    this->forward_[i] = last;
+  }
+  this->forward_[0] = 0.0f;
+  this->forward_[LUT_SEGMENTS] = 1.0f;
+
+  // Invert by bisection on the exact profile, earliest time for flat parts
+  for (uint8_t i = 0; i <= LUT_SEGMENTS; i++) {
+    const float target = float(i) / LUT_SEGMENTS;
+    float lo = 0.0f, hi = 1.0f;
+    for (uint8_t iter = 0; iter < 24; iter++) {
+      const float mid = (lo + hi) / 2.0f;
+      if (this->evaluate_(mid) < target) {
+        lo = mid;
+      } else {
+        hi = mid;
+      }
+    }
+    this->inverse_[i] = hi;
+  }
+  this->inverse_[0] = 0.0f;
+  this->inverse_[LUT_SEGMENTS] = 1.0f;
+#ifdef IMPULSE_COVER_FIXED_POINT
+  for (uint8_t i = 0; i <= LUT_SEGMENTS; i++) {
+    this->forward_fixed_[i] = to_motion(this->forward_[i]);
+    this->inverse_fixed_[i] = to_motion(this->inverse_[i]);
+  }
+#endif
+
+  ESP_LOGV(TAG, "Curve built: progress at 25/50/75%% of time = %.3f/%.3f/%.3f", this->progress_at(0.25f),
+           this->progress_at(0.5f), this->progress_at(0.75f));
+}
+
+float TravelCurve::lookup_(const float *table, float x) {
+  if (x <= 0.0f) {
+    return table[0];
+  }
+  if (x >= 1.0f) {
+    return table[LUT_SEGMENTS];
+  }
+  const float scaled = x * LUT_SEGMENTS;
+  const uint8_t index = static_cast<uint8_t>(scaled);
+  const float frac = scaled - index;
+  return table[index] + (table[index + 1] - table[index]) * frac;
+}
+
+#ifdef IMPULSE_COVER_FIXED_POINT
+motion_t TravelCurve::lookup_fixed_(const motion_t *table, motion_t x) {
+  if (x >= MOTION_ONE) {
+    return table[LUT_SEGMENTS];
+  }
+  // Tables are non-decreasing and at most MOTION_ONE, so the products fit in 32 bits
+  const uint32_t scaled = x * LUT_SEGMENTS;
+  const uint8_t index = scaled / MOTION_ONE;
+  const uint32_t frac = scaled % MOTION_ONE;
+  return table[index] + (table[index + 1] - table[index]) * frac / MOTION_ONE;
+}
+#endif
+
+}  // namespace impulse_cover
+}  // namespace esphome
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "motion_math.h"
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace impulse_cover {
+
+// Travel profile of one direction over a full endstop-to-endstop run:
+// progress (0..1 of the travel) as a function of time (0..1 of the travel
+// duration). Defined either by points of a piecewise-linear table or by
+// accel/cruise/decel phases, then sampled into forward and inverse lookup
+// tables by setup() so evaluation is an index and one interpolation.
+class TravelCurve {
+ public:
+  static const uint8_t LUT_SEGMENTS = 32;
+
+  // Piecewise-linear definition; (0, 0) and (1, 1) are implied.
+  void add_point(float time, float progress);
+  // Trapezoidal speed profile: linear ramp up over `accel` and down over
+  // `decel`, both given as fractions of the travel duration.
+  void set_phases(float accel, float decel);
+
+  void setup();
+
+  // Progress reached after `time` of a full run.
+  float progress_at(float time) const { return lookup_(this->forward_, time); }
+  // Time at which a full run reaches `progress`.
+  float time_at(float progress) const { return lookup_(this->inverse_, progress); }
+  // The same on the motion engine's number type
+#ifdef IMPULSE_COVER_FIXED_POINT
+  motion_t motion_progress_at(motion_t time) const { return lookup_fixed_(this->forward_fixed_, time); }
+  motion_t motion_time_at(motion_t progress) const { return lookup_fixed_(this->inverse_fixed_, progress); }
+#else
+  motion_t motion_progress_at(motion_t time) const { return this->progress_at(time); }
+  motion_t motion_time_at(motion_t progress) const { return this->time_at(progress); }
+#endif
+
+ protected:
+  struct Point {
+    float time;
+    float progress;
+  };
+
+  float evaluate_(float time) const;
+  static float lookup_(const float *table, float x);
+#ifdef IMPULSE_COVER_FIXED_POINT
+  static motion_t lookup_fixed_(const motion_t *table, motion_t x);
+#endif
+
+  std::vector<Point> points_;
+  float accel_{0.0f};
+  float decel_{0.0f};
+  float forward_[LUT_SEGMENTS + 1];
+  float inverse_[LUT_SEGMENTS + 1];
+#ifdef IMPULSE_COVER_FIXED_POINT
+  motion_t forward_fixed_[LUT_SEGMENTS + 1];
+  motion_t inverse_fixed_[LUT_SEGMENTS + 1];
+#endif
+};
+
+}  // namespace impulse_cover
+}  // namespace esphome
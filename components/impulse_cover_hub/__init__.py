@@ -0,0 +1,87 @@
+"""Runs the loop of several impulse covers from one component and starts
+group commands within a power budget."""
+
+from esphome import automation
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.const import CONF_ID, CONF_POSITION
+
+CODEOWNERS = ["@AntorFr"]
+
+CONF_MAX_MOVING = "max_moving"
+CONF_PULSE_SPACING = "pulse_spacing"
+CONF_INRUSH_TIME = "inrush_time"
+
+impulse_cover_hub_ns = cg.esphome_ns.namespace("impulse_cover_hub")
+ImpulseCoverHub = impulse_cover_hub_ns.class_("ImpulseCoverHub", cg.Component)
+
+# Actions
+MoveAllAction = impulse_cover_hub_ns.class_("MoveAllAction", automation.Action)
+StopAllAction = impulse_cover_hub_ns.class_("StopAllAction", automation.Action)
+
+CONFIG_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(ImpulseCoverHub),
+        cv.Optional(CONF_MAX_MOVING, default=0): cv.int_range(min=0, max=255),
+        cv.Optional(
+            CONF_PULSE_SPACING, default="0ms"
+        ): cv.positive_time_period_milliseconds,
+        cv.Optional(
+            CONF_INRUSH_TIME, default="0ms"
+        ): cv.positive_time_period_milliseconds,
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+
+    cg.add(var.set_max_moving(config[CONF_MAX_MOVING]))
+    cg.add(var.set_pulse_spacing(config[CONF_PULSE_SPACING]))
+    cg.add(var.set_inrush_time(config[CONF_INRUSH_TIME]))
+
+
+HUB_ACTION_SCHEMA = automation.maybe_simple_id(
+    {cv.Required(CONF_ID): cv.use_id(ImpulseCoverHub)}
+)
+
+
+@automation.register_action("impulse_cover_hub.open", MoveAllAction, HUB_ACTION_SCHEMA)
+async def open_all_action_to_code(config, action_id, template_arg, args):
+    hub = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(action_id, template_arg, hub)
+    cg.add(var.set_position(1.0))
+    return var
+
+
+@automation.register_action("impulse_cover_hub.close", MoveAllAction, HUB_ACTION_SCHEMA)
+async def close_all_action_to_code(config, action_id, template_arg, args):
+    hub = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(action_id, template_arg, hub)
+    cg.add(var.set_position(0.0))
+    return var
+
+
+@automation.register_action(
+    "impulse_cover_hub.set_position",
+    MoveAllAction,
+    cv.Schema(
+        {
+            cv.Required(CONF_ID): cv.use_id(ImpulseCoverHub),
+            cv.Required(CONF_POSITION): cv.templatable(cv.percentage),
+        }
+    ),
+)
+async def set_position_all_action_to_code(config, action_id, template_arg, args):
+    hub = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(action_id, template_arg, hub)
+    template_ = await cg.templatable(config[CONF_POSITION], args, float)
+    cg.add(var.set_position(template_))
+    return var
+
+
+@automation.register_action("impulse_cover_hub.stop", StopAllAction, HUB_ACTION_SCHEMA)
+async def stop_all_action_to_code(config, action_id, template_arg, args):
+    hub = await cg.get_variable(config[CONF_ID])
+    return cg.new_Pvariable(action_id, template_arg, hub)
@@ -0,0 +1,177 @@
+#include "impulse_cover_hub.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+#include <algorithm>
+#include <cmath>
+
+namespace esphome {
+namespace impulse_cover_hub {
+
+static const char *const TAG = "impulse_cover_hub";
+
+using impulse_cover::ImpulseCover;
+
+void ImpulseCoverHub::setup() {
+  // Room for every cover moving or pending at once: set_moving() and
+  // move_all() never allocate afterwards
+  this->moving_.reserve(this->covers_.size());
+  this->pending_.reserve(this->covers_.size());
+  this->started_ = true;
+  this->update_loop_();
+}
+
+void ImpulseCoverHub::loop() {
+#ifdef IMPULSE_COVER_ZERO_HEAP
+  if (this->dispatch_armed_ && static_cast<int32_t>(millis() - this->dispatch_at_) >= 0) {
+    this->dispatch_armed_ = false;
+    this->dispatch_();
+    this->update_loop_();
+  }
+#endif
+  // Backwards, so a cover going idle inside its poll() can swap-remove itself
+  for (size_t i = this->moving_.size(); i-- > 0;) {
+    if (i < this->moving_.size() && this->moving_[i]->get_motion_mode() == impulse_cover::MOTION_MODE_POLLING) {
+      this->moving_[i]->poll();
+    }
+  }
+}
+
+void ImpulseCoverHub::update_loop_() {
+  if (!this->started_)
+    return;
+  bool needed = this->polled_moving_ > 0;
+#ifdef IMPULSE_COVER_ZERO_HEAP
+  needed = needed || this->dispatch_armed_;
+#endif
+  if (needed) {
+    this->enable_loop();
+  } else {
+    this->disable_loop();
+  }
+}
+
+void ImpulseCoverHub::arm_dispatch_(uint32_t delay) {
+#ifdef IMPULSE_COVER_ZERO_HEAP
+  this->dispatch_at_ = millis() + delay;
+  this->dispatch_armed_ = true;
+  this->update_loop_();
+#else
+  this->set_timeout("dispatch", delay, [this]() { this->dispatch_(); });
+#endif
+}
+
+void ImpulseCoverHub::cancel_dispatch_() {
+#ifdef IMPULSE_COVER_ZERO_HEAP
+  this->dispatch_armed_ = false;
+  this->update_loop_();
+#else
+  this->cancel_timeout("dispatch");
+#endif
+}
+
+void ImpulseCoverHub::dump_config() {
+  ESP_LOGCONFIG(TAG, "Impulse Cover Hub:");
+  ESP_LOGCONFIG(TAG, "  Covers: %u", (unsigned) this->covers_.size());
+  if (this->max_moving_ != 0) {
+    ESP_LOGCONFIG(TAG, "  Max Moving: %u", this->max_moving_);
+  } else {
+    ESP_LOGCONFIG(TAG, "  Max Moving: unlimited");
+  }
+  ESP_LOGCONFIG(TAG, "  Pulse Spacing: %ums", this->pulse_spacing_);
+  ESP_LOGCONFIG(TAG, "  Inrush Time: %ums", this->inrush_time_);
+}
+
+void ImpulseCoverHub::set_moving(ImpulseCover *cover, bool moving) {
+  auto it = std::find(this->moving_.begin(), this->moving_.end(), cover);
+  const bool listed = it != this->moving_.end();
+  if (!moving && !listed)
+    return;
+  const bool polled = cover->get_motion_mode() == impulse_cover::MOTION_MODE_POLLING;
+  if (moving) {
+    // Every start counts against the budget, group command or not, and so does a
+    // reversal or a press sent again while listed: the motor restarts with full inrush
+    this->last_start_ = millis();
+    this->has_started_ = true;
+    // A cover commanded on its own while pending leaves the group command
+    auto pending = std::find_if(this->pending_.begin(), this->pending_.end(),
+                                [cover](const PendingMove &move) { return move.cover == cover; });
+    if (pending != this->pending_.end()) {
+      this->pending_.erase(pending);
+    }
+    if (listed)
+      return;
+    this->moving_.push_back(cover);
+    if (polled && ++this->polled_moving_ == 1) {
+      this->update_loop_();
+    }
+  } else {
+    *it = this->moving_.back();
+    this->moving_.pop_back();
+    if (polled && --this->polled_moving_ == 0) {
+      this->update_loop_();
+    }
+    if (!this->dispatching_ && !this->pending_.empty()) {
+      this->dispatch_();
+    }
+  }
+}
+
+void ImpulseCoverHub::on_motor_start(ImpulseCover *cover) {
+  // Timed from the press itself: a reversal or a plan with a lead-in restarts the
+  // motor well after the command that set_moving() saw
+  this->last_start_ = millis();
+  this->has_started_ = true;
+}
+
+void ImpulseCoverHub::move_all(float position) {
+  this->cancel_dispatch_();
+  this->pending_.clear();
+  for (ImpulseCover *cover : this->covers_) {
+    const bool opening = position > cover->position;
+    const uint32_t duration = opening ? cover->get_open_duration() : cover->get_close_duration();
+    const float travel = std::fabs(position - cover->position) * duration;
+    this->pending_.push_back({cover, position, static_cast<uint32_t>(travel)});
+  }
+  // Longest run at the back, started first
+  std::sort(this->pending_.begin(), this->pending_.end(),
+            [](const PendingMove &a, const PendingMove &b) { return a.travel < b.travel; });
+  ESP_LOGD(TAG, "Group move to %.0f%%: %u covers", position * 100.0f, (unsigned) this->pending_.size());
+  this->dispatch_();
+}
+
+void ImpulseCoverHub::stop_all() {
+  this->cancel_dispatch_();
+  this->pending_.clear();
+  // Stopping does not draw inrush current, so every cover stops right away
+  for (size_t i = this->moving_.size(); i-- > 0;) {
+    if (i < this->moving_.size()) {
+      this->moving_[i]->make_call().set_command_stop().perform();
+    }
+  }
+}
+
+void ImpulseCoverHub::dispatch_() {
+  const uint32_t spacing = std::max(this->pulse_spacing_, this->inrush_time_);
+  while (!this->pending_.empty()) {
+    if (this->max_moving_ != 0 && this->moving_.size() >= this->max_moving_) {
+      // set_moving() resumes when a cover stops
+      return;
+    }
+    const uint32_t now = millis();
+    if (this->has_started_ && now - this->last_start_ < spacing) {
+      this->arm_dispatch_(spacing - (now - this->last_start_));
+      return;
+    }
+
+    const PendingMove move = this->pending_.back();
+    this->pending_.pop_back();
+    // set_moving() records the start, reversal included; a cover already running
+    // the right way sends no press and does not restart
+    this->dispatching_ = true;
+    move.cover->make_call().set_position(move.position).perform();
+    this->dispatching_ = false;
+  }
+}
+
+}  // namespace impulse_cover_hub
+}  // namespace esphome
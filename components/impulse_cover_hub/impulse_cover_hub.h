@@ -0,0 +1,96 @@
+#pragma once
+
+#include "esphome/core/component.h"
+#include "esphome/core/automation.h"
+#include "esphome/components/impulse_cover/impulse_cover.h"
+#include <vector>
+
+namespace esphome {
+namespace impulse_cover_hub {
+
+// One loop() for all attached covers. Covers disable their own loop and hand
+// themselves over while they move, so an idle node with many covers has no
+// cover loop work at all and a busy one pays only for the moving covers.
+//
+// Group commands (move_all()) are started cover by cover within a power
+// budget: at most max_moving motors running, and consecutive starts at least
+// pulse_spacing and inrush_time apart. Longest runs start first, which gives
+// the shortest total time for the budget.
+class ImpulseCoverHub : public Component, public impulse_cover::LoopDriver {
+ public:
+  void setup() override;
+  void loop() override;
+  void dump_config() override;
+  float get_setup_priority() const override { return setup_priority::HARDWARE; }
+
+  void register_cover(impulse_cover::ImpulseCover *cover) { this->covers_.push_back(cover); }
+  void set_moving(impulse_cover::ImpulseCover *cover, bool moving) override;
+  void on_motor_start(impulse_cover::ImpulseCover *cover) override;
+
+  void set_max_moving(uint8_t max_moving) { this->max_moving_ = max_moving; }
+  void set_pulse_spacing(uint32_t pulse_spacing) { this->pulse_spacing_ = pulse_spacing; }
+  void set_inrush_time(uint32_t inrush_time) { this->inrush_time_ = inrush_time; }
+
+  // Group command: every cover to `position`, started one by one within the budget
+  void move_all(float position);
+  // Stops every moving cover at once and drops the starts still pending
+  void stop_all();
+
+  size_t get_moving_count() const { return this->moving_.size(); }
+  size_t get_pending_count() const { return this->pending_.size(); }
+
+ protected:
+  struct PendingMove {
+    impulse_cover::ImpulseCover *cover;
+    float position;
+    uint32_t travel;  // estimated run time, ms
+  };
+
+  // Starts pending moves while the budget allows, then waits for a cover to
+  // stop or for the start spacing to elapse
+  void dispatch_();
+  // Runs dispatch_() after delay ms; in zero-heap mode a deadline checked by loop()
+  void arm_dispatch_(uint32_t delay);
+  void cancel_dispatch_();
+  void update_loop_();
+
+  std::vector<impulse_cover::ImpulseCover *> covers_;
+  std::vector<impulse_cover::ImpulseCover *> moving_;
+  std::vector<PendingMove> pending_;  // next to start at the back
+  uint8_t polled_moving_{0};          // moving covers whose loop() the hub runs
+  uint8_t max_moving_{0};             // 0: no limit
+  uint32_t pulse_spacing_{0};
+  uint32_t inrush_time_{0};
+  uint32_t last_start_{0};
+  bool has_started_{false};
+  bool dispatching_{false};
+  bool started_{false};  // loop state is only touched after setup()
+#ifdef IMPULSE_COVER_ZERO_HEAP
+  uint32_t dispatch_at_{0};
+  bool dispatch_armed_{false};
+#endif
+};
+
+template<typename... Ts> class MoveAllAction : public Action<Ts...> {
+ public:
+  explicit MoveAllAction(ImpulseCoverHub *hub) : hub_(hub) {}
+  TEMPLATABLE_VALUE(float, position)
+
+  void play(Ts... x) override { this->hub_->move_all(this->position_.value(x...)); }
+
+ protected:
+  ImpulseCoverHub *hub_;
+};
+
+template<typename... Ts> class StopAllAction : public Action<Ts...> {
+ public:
+  explicit StopAllAction(ImpulseCoverHub *hub) : hub_(hub) {}
+
+  void play(Ts... x) override { this->hub_->stop_all(); }
+
+ protected:
+  ImpulseCoverHub *hub_;
+};
+
+}  // namespace impulse_cover_hub
+}  // namespace esphome
@@ -0,0 +1,302 @@
+// Microbenchmarks for the ImpulseCover control hot path on the host build.
+//
+//   impulse_cover_bench [--iterations N] [--filter SUBSTR] [--csv]
+//
+// Reports ns/call and heap allocations/bytes per call. The ESPHome core
+// stand-in formats every enabled log statement like the device logger does,
+// so logging cost is part of the numbers. Absolute times are host times; use
+// them to compare releases, not to predict ESP32 cycles.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "esphome/core/log.h"
+#include "host_env.h"
+#include "sim_cover.h"
+
+// ---- allocation accounting -------------------------------------------------
+
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+static uint64_t g_allocs = 0;
+static uint64_t g_alloc_bytes = 0;
+
+void *operator new(size_t size) {
+  g_allocs++;
+  g_alloc_bytes += size;
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+void operator delete[](void *p, size_t) noexcept { std::free(p); }
+
+namespace esphome {
+namespace impulse_cover {
+
+// Calls the protected hot-path methods under test on whichever TopologyCover
+// the fixture built.
+class HotPathAccess {
+ public:
+  explicit HotPathAccess(ImpulseCover &cover) : cover_(cover) {}
+
+  void control(const cover::CoverCall &call) { this->cover_.control(call); }
+  void recompute_position_() { this->cover_.recompute_position_(); }
+  void start_direction_(cover::CoverOperation dir) { this->cover_.start_direction_(dir); }
+  void update_position_from_sensors_(bool is_initialization) {
+    this->cover_.update_position_from_sensors_(is_initialization);
+  }
+
+ protected:
+  ImpulseCover &cover_;
+};
+
+}  // namespace impulse_cover
+}  // namespace esphome
+
+namespace {
+
+using namespace impulse_sim;
+using esphome::cover::COVER_OPERATION_CLOSING;
+using esphome::cover::COVER_OPERATION_IDLE;
+using esphome::cover::COVER_OPERATION_OPENING;
+using Clock = std::chrono::steady_clock;
+
+using esphome::impulse_cover::HotPathAccess;
+
+struct Result {
+  std::string name;
+  uint64_t calls;
+  double ns_per_call;
+  double allocs_per_call;
+  double bytes_per_call;
+};
+
+struct Options {
+  uint32_t iterations{200000};
+  std::string filter;
+  bool csv{false};
+};
+
+class Bench {
+ public:
+  explicit Bench(const Options &opt) : opt_(opt) {}
+
+  bool enabled(const char *name) const {
+    return this->opt_.filter.empty() || std::strstr(name, this->opt_.filter.c_str()) != nullptr;
+  }
+
+  // Times `body` in one batch; it must leave the cover ready for the next call.
+  template<typename Body> void batch(const char *name, uint32_t calls, Body &&body) {
+    if (!this->enabled(name))
+      return;
+    const uint64_t allocs = g_allocs, bytes = g_alloc_bytes;
+    const auto start = Clock::now();
+    for (uint32_t i = 0; i < calls; i++)
+      body(i);
+    const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    this->record_(name, calls, ns, g_allocs - allocs, g_alloc_bytes - bytes);
+  }
+
+  // Times `body` call by call, with untimed `prepare` in between. The cost of
+  // reading the clock is measured once and subtracted.
+  template<typename Prepare, typename Body>
+  void each(const char *name, uint32_t calls, Prepare &&prepare, Body &&body) {
+    if (!this->enabled(name))
+      return;
+    double ns = 0;
+    uint64_t allocs = 0, bytes = 0;
+    for (uint32_t i = 0; i < calls; i++) {
+      prepare(i);
+      const uint64_t a0 = g_allocs, b0 = g_alloc_bytes;
+      const auto start = Clock::now();
+      body(i);
+      const auto end = Clock::now();
+      allocs += g_allocs - a0;
+      bytes += g_alloc_bytes - b0;
+      ns += std::chrono::duration<double, std::nano>(end - start).count() - this->clock_overhead_ns_();
+    }
+    this->record_(name, calls, ns, allocs, bytes);
+  }
+
+  void print() const {
+    if (this->opt_.csv) {
+      std::printf("benchmark,calls,ns_per_call,allocs_per_call,bytes_per_call\n");
+      for (const auto &r : this->results_)
+        std::printf("%s,%llu,%.1f,%.3f,%.1f\n", r.name.c_str(), (unsigned long long) r.calls,
+                    r.ns_per_call, r.allocs_per_call, r.bytes_per_call);
+      return;
+    }
+    std::printf("%-32s %10s %10s %12s %12s\n", "benchmark", "calls", "ns/call", "allocs/call",
+                "bytes/call");
+    for (const auto &r : this->results_)
+      std::printf("%-32s %10llu %10.1f %12.3f %12.1f\n", r.name.c_str(), (unsigned long long) r.calls,
+                  r.ns_per_call, r.allocs_per_call, r.bytes_per_call);
+  }
+
+ protected:
+  double clock_overhead_ns_() {
+    if (this->overhead_ns_ < 0) {
+      const int n = 100000;
+      double total = 0;
+      for (int i = 0; i < n; i++) {
+        const auto a = Clock::now();
+        const auto b = Clock::now();
+        total += std::chrono::duration<double, std::nano>(b - a).count();
+      }
+      this->overhead_ns_ = total / n;
+    }
+    return this->overhead_ns_;
+  }
+
+  void record_(const char *name, uint64_t calls, double ns, uint64_t allocs, uint64_t bytes) {
+    this->results_.push_back({name, calls, ns / calls, double(allocs) / calls, double(bytes) / calls});
+  }
+
+  Options opt_;
+  std::vector<Result> results_;
+  double overhead_ns_{-1};
+};
+
+void advance_ms(uint32_t ms) { set_now_us(now_us() + uint64_t(ms) * 1000); }
+
+// Runs timers until nothing is pending (pulse off edges, deferred pulses). With
+// IMPULSE_COVER_ZERO_HEAP they are the cover's timer slots, run by its loop().
+void drain(esphome::impulse_cover::ImpulseCover &cover, uint32_t step_ms) {
+  for (int guard = 0; guard < 64 && scheduler_pending() > 0; guard++) {
+    advance_ms(step_ms);
+    scheduler_run_due();
+  }
+#ifdef IMPULSE_COVER_ZERO_HEAP
+  // A double pulse is four steps of step_ms
+  for (int step = 0; step < 4; step++) {
+    advance_ms(step_ms);
+    cover.loop();
+  }
+#endif
+}
+
+// A cover with both endstops, durations long enough that a move never ends
+// during a benchmark, parked closed and idle.
+struct Fixture {
+  Fixture() {
+    reset_now_us();
+    scheduler_reset();
+    preferences_reset(false);
+    GateConfig gate;
+    gate.open_time_ms = gate.close_time_ms = 24 * 3600 * 1000;
+    CoverSetup setup;
+    setup.open_duration_ms = setup.close_duration_ms = gate.open_time_ms;
+    this->unit = new SimCover("Bench Gate", gate, setup);
+    this->unit->open_sensor.publish_state(false);
+    this->unit->close_sensor.publish_state(true);
+    this->unit->cover.setup();
+    advance_ms(1000);
+  }
+  ~Fixture() {
+    scheduler_reset();
+    delete this->unit;
+  }
+
+  esphome::impulse_cover::ImpulseCover &cover() { return this->unit->cover; }
+  HotPathAccess hot() { return HotPathAccess(this->unit->cover); }
+
+  void start_moving() {
+    this->unit->close_sensor.publish_state(false);
+    this->cover().make_call().set_position(1.0f).perform();
+    drain(this->cover(), this->unit->setup.pulse_delay_ms);
+  }
+
+  SimCover *unit;
+};
+
+void run_all(Bench &b, uint32_t n) {
+  {
+    Fixture f;
+    b.batch("loop_idle", n, [&](uint32_t) {
+      advance_ms(1);
+      f.cover().loop();
+    });
+  }
+  {
+    Fixture f;
+    f.start_moving();
+    b.batch("loop_moving", n, [&](uint32_t) {
+      advance_ms(1);
+      f.cover().loop();
+    });
+  }
+  {
+    Fixture f;
+    f.start_moving();
+    b.batch("recompute_position", n, [&](uint32_t) {
+      advance_ms(1);
+      f.hot().recompute_position_();
+    });
+  }
+  {
+    Fixture f;
+    b.batch("update_position_from_sensors", n,
+            [&](uint32_t) { f.hot().update_position_from_sensors_(false); });
+  }
+
+  // Command paths change state, so every call is prepared from the same
+  // starting point: idle half way, safety counters cleared, no pending timers.
+  const uint32_t commands = n / 10 + 1;
+  {
+    Fixture f;
+    f.unit->close_sensor.publish_state(false);
+    f.cover().position = 0.5f;
+    auto prepare = [&](uint32_t) {
+      if (f.cover().current_operation != COVER_OPERATION_IDLE)
+        f.hot().start_direction_(COVER_OPERATION_IDLE);
+      drain(f.cover(), f.unit->setup.pulse_delay_ms);
+      f.cover().reset_safety_mode();
+      f.cover().position = 0.5f;
+    };
+    b.each("control_position", commands, prepare, [&](uint32_t i) {
+      auto call = f.cover().make_call();
+      call.set_position(i % 2 ? 0.3f : 0.7f);
+      f.hot().control(call);
+    });
+    b.each("start_direction", commands, prepare, [&](uint32_t i) {
+      f.hot().start_direction_(i % 2 ? COVER_OPERATION_CLOSING : COVER_OPERATION_OPENING);
+    });
+    b.each("start_direction_and_pulses", commands, prepare, [&](uint32_t i) {
+      f.hot().start_direction_(i % 2 ? COVER_OPERATION_CLOSING : COVER_OPERATION_OPENING);
+      drain(f.cover(), f.unit->setup.pulse_delay_ms);
+    });
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  Options opt;
+  for (int i = 1; i < argc; i++) {
+    if (!std::strcmp(argv[i], "--iterations") && i + 1 < argc) {
+      opt.iterations = std::strtoul(argv[++i], nullptr, 10);
+    } else if (!std::strcmp(argv[i], "--filter") && i + 1 < argc) {
+      opt.filter = argv[++i];
+    } else if (!std::strcmp(argv[i], "--csv")) {
+      opt.csv = true;
+    } else {
+      std::fprintf(stderr, "Usage: %s [--iterations N] [--filter SUBSTR] [--csv]\n", argv[0]);
+      return 2;
+    }
+  }
+  set_log_level(ESPHOME_LOG_LEVEL_NONE);
+
+  Bench b(opt);
+  run_all(b, opt.iterations);
+  b.print();
+  return 0;
+}
@@ -0,0 +1,206 @@
+#include "gate_model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace impulse_sim {
+
+static GateMotion opposite(GateMotion dir) {
+  return dir == GateMotion::OPENING ? GateMotion::CLOSING : GateMotion::OPENING;
+}
+
+GateModel::GateModel(const GateConfig &config, uint32_t seed)
+    : config_(config), rng_(seed), position_(config.initial_position), obstacle_(config.obstacle) {
+  this->next_dir_ = this->position_ >= 1.0f ? GateMotion::CLOSING : GateMotion::OPENING;
+}
+
+bool GateModel::is_settled() const {
+  if (this->moving_ != GateMotion::STOPPED || this->pending_dir_ != GateMotion::STOPPED)
+    return false;
+  return std::none_of(std::begin(this->input_), std::end(this->input_), [](bool input) { return input; });
+}
+
+float GateModel::motor_current() const {
+  if (this->moving_ == GateMotion::STOPPED || this->coasting_)
+    return 0.0f;
+  return this->jammed_ ? this->config_.stall_current : this->config_.motor_current;
+}
+
+void GateModel::set_input(GateInput input, bool level, uint32_t now_ms) {
+  const uint8_t i = static_cast<uint8_t>(input);
+  if (level == this->input_[i])
+    return;
+  this->input_[i] = level;
+  if (level) {
+    this->input_rise_ms_[i] = now_ms;
+    this->press_handled_[i] = false;
+    this->stats_.presses_seen++;
+  }
+}
+
+bool GateModel::accept_(uint32_t now_ms) {
+  if (this->has_pressed_ && now_ms - this->last_press_ms_ < this->config_.input_lockout_ms)
+    return false;
+  if (this->config_.pulse_miss_probability > 0.0f) {
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    if (dist(this->rng_) < this->config_.pulse_miss_probability) {
+      this->stats_.presses_missed++;
+      return false;
+    }
+  }
+  this->stats_.presses_accepted++;
+  this->last_press_ms_ = now_ms;
+  this->has_pressed_ = true;
+  return true;
+}
+
+void GateModel::press_(uint32_t now_ms) {
+  if (this->fsm_ != GateMotion::STOPPED) {
+    // Running (or about to run): stop, next press goes the other way. A reversing
+    // cycle starts that way once the gate has coasted to rest.
+    const bool reverse = this->config_.cycle == GateCycle::OPEN_CLOSE_OPEN ||
+                         (this->config_.cycle == GateCycle::OPEN_STOP_CLOSE && this->fsm_ == GateMotion::CLOSING);
+    this->stop_(now_ms);
+    if (!reverse)
+      return;
+  }
+
+  GateMotion dir = this->next_dir_;
+  if (dir == GateMotion::OPENING && this->position_ >= 1.0f)
+    dir = GateMotion::CLOSING;
+  else if (dir == GateMotion::CLOSING && this->position_ <= 0.0f)
+    dir = GateMotion::OPENING;
+  this->start_(dir, now_ms);
+}
+
+void GateModel::command_(GateInput input, uint32_t now_ms) {
+  // A dedicated input: the controller does what it says whatever state it is in
+  if (input == GateInput::STOP) {
+    if (this->fsm_ != GateMotion::STOPPED)
+      this->stop_(now_ms);
+    return;
+  }
+  const GateMotion dir = input == GateInput::OPEN ? GateMotion::OPENING : GateMotion::CLOSING;
+  if (this->fsm_ == dir || this->position_ == (dir == GateMotion::OPENING ? 1.0f : 0.0f))
+    return;
+  if (this->fsm_ != GateMotion::STOPPED)
+    this->stop_(now_ms);
+  this->start_(dir, now_ms);
+}
+
+void GateModel::stop_(uint32_t now_ms) {
+  this->next_dir_ = opposite(this->fsm_);
+  this->fsm_ = GateMotion::STOPPED;
+  if (this->pending_dir_ != GateMotion::STOPPED) {
+    this->pending_dir_ = GateMotion::STOPPED;
+  } else if (this->moving_ != GateMotion::STOPPED && !this->coasting_) {
+    this->coasting_ = true;
+    this->coast_until_ = now_ms + this->config_.coast_ms;
+  }
+}
+
+void GateModel::start_(GateMotion dir, uint32_t now_ms) {
+  this->fsm_ = dir;
+  this->pending_dir_ = dir;
+  const uint32_t free_at = this->coasting_ ? std::max(now_ms, this->coast_until_) : now_ms;
+  this->pending_start_at_ = free_at + this->config_.motor_start_delay_ms;
+}
+
+float GateModel::speed_per_ms_(uint32_t now_ms) const {
+  const bool opening = this->moving_ == GateMotion::OPENING;
+  float speed = opening ? this->config_.speed_factor_open / this->config_.open_time_ms
+                        : this->config_.speed_factor_close / this->config_.close_time_ms;
+  if (this->config_.soft_start_ms > 0) {
+    const uint32_t since_start = now_ms - this->motion_started_at_;
+    if (since_start < this->config_.soft_start_ms)
+      speed *= std::max(0.05f, float(since_start) / this->config_.soft_start_ms);
+  }
+  if (this->config_.slowdown_zone > 0.0f) {
+    const float remaining = opening ? 1.0f - this->position_ : this->position_;
+    if (remaining < this->config_.slowdown_zone)
+      speed *= this->config_.slowdown_speed;
+  }
+  return speed;
+}
+
+void GateModel::step(uint32_t now_ms) {
+  for (uint8_t i = 0; i < INPUT_COUNT; i++) {
+    if (this->input_[i] && !this->press_handled_[i] &&
+        now_ms - this->input_rise_ms_[i] >= this->config_.input_min_width_ms) {
+      this->press_handled_[i] = true;
+      if (!this->accept_(now_ms))
+        continue;
+      const GateInput input = static_cast<GateInput>(i);
+      if (input == GateInput::IMPULSE) {
+        this->press_(now_ms);
+      } else {
+        this->command_(input, now_ms);
+      }
+    }
+  }
+
+  if (this->coasting_ && now_ms >= this->coast_until_) {
+    this->coasting_ = false;
+    this->jammed_ = false;
+    this->moving_ = GateMotion::STOPPED;
+    this->stats_.last_stop_ms = now_ms;
+  }
+
+  if (this->pending_dir_ != GateMotion::STOPPED && !this->coasting_ &&
+      now_ms >= this->pending_start_at_) {
+    this->moving_ = this->pending_dir_;
+    this->pending_dir_ = GateMotion::STOPPED;
+    this->motion_started_at_ = now_ms;
+    this->stats_.motion_starts++;
+    this->stats_.last_motion_start_ms = now_ms;
+  }
+
+  if (this->moving_ == GateMotion::STOPPED)
+    return;
+  if (this->jammed_) {
+    if (!this->coasting_ && now_ms - this->jammed_at_ >= this->config_.stall_cut_ms) {
+      this->stop_(now_ms);
+      this->coasting_ = false;
+      this->jammed_ = false;
+      this->moving_ = GateMotion::STOPPED;
+      this->stats_.last_stop_ms = now_ms;
+    }
+    return;
+  }
+
+  const float delta = this->speed_per_ms_(now_ms);
+  const float before = this->position_;
+  if (this->moving_ == GateMotion::OPENING) {
+    this->position_ += delta;
+    if (this->position_ >= 1.0f) {
+      this->position_ = 1.0f;
+      this->next_dir_ = GateMotion::CLOSING;
+    }
+  } else {
+    this->position_ -= delta;
+    if (this->obstacle_ >= 0.0f && this->position_ <= this->obstacle_) {
+      // Pushes against it until stopped; whoever put it there takes it away meanwhile
+      this->position_ = this->obstacle_;
+      this->obstacle_ = -1.0f;
+      this->jammed_ = true;
+      this->jammed_at_ = now_ms;
+    }
+    if (this->position_ <= 0.0f) {
+      this->position_ = 0.0f;
+      this->next_dir_ = GateMotion::OPENING;
+    }
+  }
+  this->odometer_ += std::fabs(this->position_ - before);
+
+  if (this->position_ == 1.0f || this->position_ == 0.0f) {
+    // Limit switch inside the controller: motor off, cycle resets.
+    this->moving_ = GateMotion::STOPPED;
+    this->fsm_ = GateMotion::STOPPED;
+    this->coasting_ = false;
+    this->stats_.endstop_arrivals++;
+    this->stats_.last_stop_ms = now_ms;
+  }
+}
+
+}  // namespace impulse_sim
@@ -0,0 +1,119 @@
+#pragma once
+
+// Physics model of a gate controller driven by ImpulseCover's relay outputs.
+// Each accepted press of the impulse input advances the controller one step
+// of its cycle, by default the common open -> stop -> close -> stop; the
+// dedicated open, close and stop inputs go straight to their command.
+
+#include <cstdint>
+#include <random>
+
+namespace impulse_sim {
+
+enum class GateMotion : uint8_t { STOPPED = 0, OPENING, CLOSING };
+
+// What a press does to a moving gate; the cover's controller_profile names them alike
+enum class GateCycle : uint8_t {
+  OPEN_STOP_CLOSE_STOP = 0,  // stops it
+  OPEN_STOP_CLOSE,           // stops it while opening, reverses it while closing
+  OPEN_CLOSE_OPEN,           // reverses it
+};
+
+// Controller inputs a relay can be wired to
+enum class GateInput : uint8_t { IMPULSE = 0, OPEN, CLOSE, STOP, COUNT };
+
+struct GateConfig {
+  uint32_t open_time_ms{15000};   // full travel at nominal speed
+  uint32_t close_time_ms{15000};
+  float speed_factor_open{1.0f};  // actual speed / nominal speed
+  float speed_factor_close{1.0f};
+  uint32_t motor_start_delay_ms{150};  // accepted press -> first movement
+  uint32_t coast_ms{120};              // travel after a stop press is accepted
+  uint32_t soft_start_ms{0};           // linear ramp to full speed after a start
+  float slowdown_zone{0.0f};           // fraction of travel near each end run at slowdown_speed
+  float slowdown_speed{0.5f};
+  uint32_t input_min_width_ms{50};  // shorter presses are ignored
+  uint32_t input_lockout_ms{0};     // presses closer than this to the previous one are ignored
+  float pulse_miss_probability{0.0f};
+  float endstop_band{0.002f};  // endstop reads active within this distance of the end
+  float initial_position{0.0f};
+  float motor_current{1.0f};    // drawn while the motor drives the gate, none while it coasts
+  float stall_current{3.0f};    // drawn while it pushes against an obstacle
+  float obstacle{-1.0f};        // a closing gate jams here once; negative for none
+  uint32_t stall_cut_ms{2000};  // the controller's overload cut-out stops a jammed motor
+  GateCycle cycle{GateCycle::OPEN_STOP_CLOSE_STOP};
+};
+
+struct GateStats {
+  uint32_t presses_seen{0};
+  uint32_t presses_accepted{0};
+  uint32_t presses_missed{0};
+  uint32_t motion_starts{0};
+  uint32_t endstop_arrivals{0};
+  uint32_t last_motion_start_ms{0};
+  uint32_t last_stop_ms{0};
+};
+
+class GateModel {
+ public:
+  explicit GateModel(const GateConfig &config, uint32_t seed = 1);
+
+  // Relay contact state as seen on one of the controller's inputs.
+  void set_input(GateInput input, bool level, uint32_t now_ms);
+  void set_input(bool level, uint32_t now_ms) { this->set_input(GateInput::IMPULSE, level, now_ms); }
+  // Advance physics by one millisecond ending at now_ms.
+  void step(uint32_t now_ms);
+
+  float position() const { return this->position_; }
+  // Travel in either direction since the start, as an encoder on the motor counts it
+  double odometer() const { return this->odometer_; }
+  float motor_current() const;
+  GateMotion motion() const { return this->moving_; }
+  GateMotion controller_state() const { return this->fsm_; }
+  bool is_moving() const { return this->moving_ != GateMotion::STOPPED; }
+  bool is_settled() const;
+  bool open_endstop_active() const { return this->position_ >= 1.0f - this->config_.endstop_band; }
+  bool close_endstop_active() const { return this->position_ <= this->config_.endstop_band; }
+
+  GateConfig &config() { return this->config_; }
+  const GateStats &stats() const { return this->stats_; }
+
+ protected:
+  bool accept_(uint32_t now_ms);
+  void press_(uint32_t now_ms);
+  void command_(GateInput input, uint32_t now_ms);
+  void stop_(uint32_t now_ms);
+  void start_(GateMotion dir, uint32_t now_ms);
+  float speed_per_ms_(uint32_t now_ms) const;
+
+  GateConfig config_;
+  GateStats stats_;
+  std::mt19937 rng_;
+
+  // Controller (logical) state
+  GateMotion fsm_{GateMotion::STOPPED};
+  GateMotion next_dir_{GateMotion::OPENING};
+
+  // Physical state
+  float position_;
+  double odometer_{0.0};  // double so hours of 1 ms steps still add up
+  GateMotion moving_{GateMotion::STOPPED};
+  GateMotion pending_dir_{GateMotion::STOPPED};
+  uint32_t pending_start_at_{0};
+  uint32_t motion_started_at_{0};
+  uint32_t coast_until_{0};
+  bool coasting_{false};
+  float obstacle_;
+  bool jammed_{false};
+  uint32_t jammed_at_{0};
+
+  // Input edge tracking, per input
+  static const uint8_t INPUT_COUNT = static_cast<uint8_t>(GateInput::COUNT);
+  bool input_[INPUT_COUNT]{};
+  uint32_t input_rise_ms_[INPUT_COUNT]{};
+  bool press_handled_[INPUT_COUNT]{};
+  uint32_t last_press_ms_{0};
+  bool has_pressed_{false};
+};
+
+}  // namespace impulse_sim
@@ -0,0 +1,121 @@
+#include "heap_audit.h"
+
+#include <cxxabi.h>
+#include <execinfo.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "host_env.h"
+
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+namespace impulse_sim {
+
+namespace {
+
+struct Site {
+  void *frames[8];
+  int depth;
+  uint64_t count;
+};
+
+const int MAX_SITES = 8;
+// Frames of the audit itself and operator new, dropped from a site
+const int SKIP_FRAMES = 2;
+// Innermost frames that tell sites apart; the outer ones are only printed
+const int KEY_FRAMES = 3;
+
+bool g_enabled = false;
+bool g_recording = false;  // backtrace() may allocate the first time
+uint64_t g_allocs = 0;
+uint64_t g_bytes = 0;
+Site g_sites[MAX_SITES];
+int g_site_count = 0;
+
+void __attribute__((noinline)) record(size_t size) {
+  if (!g_enabled || g_recording || !in_steady_component_scope())
+    return;
+  g_recording = true;
+  g_allocs++;
+  g_bytes += size;
+  void *frames[8 + SKIP_FRAMES];
+  const int depth = backtrace(frames, 8 + SKIP_FRAMES) - SKIP_FRAMES;
+  bool known = false;
+  for (int i = 0; i < g_site_count && !known; i++) {
+    Site &site = g_sites[i];
+    const int key = std::min(depth, KEY_FRAMES);
+    if (site.depth >= key && std::memcmp(site.frames, frames + SKIP_FRAMES, key * sizeof(void *)) == 0) {
+      site.count++;
+      known = true;
+    }
+  }
+  if (!known && depth > 0 && g_site_count < MAX_SITES) {
+    Site &site = g_sites[g_site_count++];
+    std::memcpy(site.frames, frames + SKIP_FRAMES, depth * sizeof(void *));
+    site.depth = depth;
+    site.count = 1;
+  }
+  g_recording = false;
+}
+
+// "binary(mangled+0x12) [0x...]" -> demangled function name, or the line as is
+void print_frame(const char *symbol) {
+  const char *begin = std::strchr(symbol, '(');
+  const char *end = begin != nullptr ? std::strpbrk(begin, "+)") : nullptr;
+  if (begin != nullptr && end != nullptr && end > begin + 1) {
+    char mangled[512];
+    const size_t len = std::min<size_t>(end - begin - 1, sizeof(mangled) - 1);
+    std::memcpy(mangled, begin + 1, len);
+    mangled[len] = '\0';
+    int status = 0;
+    char *name = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+    if (status == 0 && name != nullptr) {
+      std::printf("      %s\n", name);
+      std::free(name);
+      return;
+    }
+    std::free(name);
+  }
+  std::printf("      %s\n", symbol);
+}
+
+}  // namespace
+
+void heap_audit_enable() { g_enabled = true; }
+uint64_t heap_audit_allocs() { return g_allocs; }
+
+void heap_audit_report() {
+  std::printf("\n== heap audit ==\n");
+  std::printf("  heap_allocs_after_setup %llu (%llu bytes)\n", (unsigned long long) g_allocs,
+              (unsigned long long) g_bytes);
+  g_recording = true;
+  for (int i = 0; i < g_site_count; i++) {
+    const Site &site = g_sites[i];
+    std::printf("  site %d: %llu allocs\n", i + 1, (unsigned long long) site.count);
+    char **symbols = backtrace_symbols(site.frames, site.depth);
+    if (symbols == nullptr)
+      continue;
+    for (int f = 0; f < site.depth; f++)
+      print_frame(symbols[f]);
+    std::free(symbols);
+  }
+  g_recording = false;
+}
+
+}  // namespace impulse_sim
+
+void *operator new(size_t size) {
+  impulse_sim::record(size);
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+void operator delete[](void *p, size_t) noexcept { std::free(p); }
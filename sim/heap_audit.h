@@ -0,0 +1,17 @@
+#pragma once
+
+// Heap audit of impulse_cover_sim (--heap-audit): counts every allocation made
+// in component code after setup (see ComponentScope in host_env.h) and keeps
+// the call stacks of the first distinct sites. heap_audit.cpp replaces the
+// global operator new, so it is linked into the simulator binary only.
+
+#include <cstdint>
+
+namespace impulse_sim {
+
+void heap_audit_enable();
+uint64_t heap_audit_allocs();
+// Count, bytes and the recorded sites as a report section on stdout
+void heap_audit_report();
+
+}  // namespace impulse_sim
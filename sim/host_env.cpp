@@ -0,0 +1,378 @@
+#include "host_env.h"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "esphome/components/binary_sensor/binary_sensor.h"
+#include "esphome/components/cover/cover.h"
+#include "esphome/core/application.h"
+#include "esphome/core/component.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+#include "esphome/core/preferences.h"
+
+namespace impulse_sim {
+
+namespace {
+
+uint64_t g_now_us = 0;
+int g_log_level = ESPHOME_LOG_LEVEL_WARN;
+
+struct SchedulerItem {
+  esphome::Component *component;
+  std::string name;
+  uint64_t due_us;
+  uint32_t interval_ms;  // 0 for timeouts
+  uint64_t seq;
+  std::function<void()> callback;
+  bool removed{false};
+};
+
+std::vector<std::unique_ptr<SchedulerItem>> g_items;
+uint64_t g_seq = 0;
+int g_scope_depth = 0;
+bool g_steady = false;
+
+bool cancel_item(esphome::Component *component, const std::string &name, bool interval) {
+  bool found = false;
+  for (auto &item : g_items) {
+    if (item->removed || item->component != component || item->name != name)
+      continue;
+    if ((item->interval_ms != 0) != interval)
+      continue;
+    item->removed = true;
+    found = true;
+  }
+  return found;
+}
+
+void add_item(esphome::Component *component, const std::string &name, uint32_t delay_ms,
+              uint32_t interval_ms, std::function<void()> &&f) {
+  if (!name.empty())
+    cancel_item(component, name, interval_ms != 0);
+  auto item = std::make_unique<SchedulerItem>();
+  item->component = component;
+  item->name = name;
+  item->due_us = g_now_us + uint64_t(delay_ms) * 1000;
+  item->interval_ms = interval_ms;
+  item->seq = g_seq++;
+  item->callback = std::move(f);
+  g_items.push_back(std::move(item));
+}
+
+struct Preference : public esphome::ESPPreferenceBackend {
+  // Sized up front like a flash slot, so saves after setup allocate nothing
+  explicit Preference(size_t length) : length(length), bytes(length) {}
+
+  bool save(const uint8_t *data, size_t len) override {
+    stats.save_calls++;
+    if (len != this->length)
+      return false;
+    if (!this->valid || std::memcmp(this->bytes.data(), data, len) != 0)
+      stats.flash_writes++;
+    this->bytes.assign(data, data + len);
+    this->valid = true;
+    return true;
+  }
+
+  bool load(uint8_t *data, size_t len) override {
+    if (!this->valid || len != this->length)
+      return false;
+    std::memcpy(data, this->bytes.data(), len);
+    return true;
+  }
+
+  size_t length;
+  std::vector<uint8_t> bytes;
+  bool valid{false};
+  static PreferenceStats stats;
+};
+PreferenceStats Preference::stats;
+
+class HostPreferences : public esphome::ESPPreferences {
+ public:
+  esphome::ESPPreferenceObject make_preference(size_t length, uint32_t type,
+                                               bool in_flash) override {
+    return this->make_preference(length, type);
+  }
+  esphome::ESPPreferenceObject make_preference(size_t length, uint32_t type) override {
+    auto &slot = this->slots_[type];
+    if (!slot || slot->length != length)
+      slot = std::make_unique<Preference>(length);
+    return esphome::ESPPreferenceObject(slot.get());
+  }
+  bool sync() override { return true; }
+
+  void reset(bool keep_data) {
+    if (!keep_data)
+      this->slots_.clear();
+    Preference::stats = {};
+  }
+
+ protected:
+  std::map<uint32_t, std::unique_ptr<Preference>> slots_;
+};
+
+HostPreferences g_preferences;
+
+}  // namespace
+
+uint64_t now_us() { return g_now_us; }
+void set_now_us(uint64_t now) { g_now_us = std::max(g_now_us, now); }
+void reset_now_us() { g_now_us = 0; }
+
+bool scheduler_next_due_us(uint64_t *due) {
+  bool any = false;
+  for (auto &item : g_items) {
+    if (item->removed)
+      continue;
+    if (!any || item->due_us < *due)
+      *due = item->due_us;
+    any = true;
+  }
+  return any;
+}
+
+void scheduler_run_due() {
+  // Same contract as esphome::Scheduler::call(): items due now run in
+  // deadline order; items added while running wait for the next pass.
+  std::vector<SchedulerItem *> due;
+  for (auto &item : g_items) {
+    if (!item->removed && item->due_us <= g_now_us)
+      due.push_back(item.get());
+  }
+  std::sort(due.begin(), due.end(), [](const SchedulerItem *a, const SchedulerItem *b) {
+    return a->due_us != b->due_us ? a->due_us < b->due_us : a->seq < b->seq;
+  });
+  for (auto *item : due) {
+    if (item->removed)
+      continue;
+    if (item->interval_ms == 0) {
+      item->removed = true;
+      auto callback = std::move(item->callback);
+      ComponentScope scope;
+      callback();
+    } else {
+      item->due_us += uint64_t(item->interval_ms) * 1000;
+      if (item->due_us <= g_now_us)
+        item->due_us = g_now_us + uint64_t(item->interval_ms) * 1000;
+      ComponentScope scope;
+      item->callback();
+    }
+  }
+  g_items.erase(std::remove_if(g_items.begin(), g_items.end(),
+                               [](const std::unique_ptr<SchedulerItem> &item) { return item->removed; }),
+                g_items.end());
+}
+
+size_t scheduler_pending() {
+  return std::count_if(g_items.begin(), g_items.end(),
+                       [](const std::unique_ptr<SchedulerItem> &item) { return !item->removed; });
+}
+
+void scheduler_reset() { g_items.clear(); }
+
+ComponentScope::ComponentScope() { g_scope_depth++; }
+ComponentScope::~ComponentScope() { g_scope_depth--; }
+bool in_steady_component_scope() { return g_steady && g_scope_depth > 0; }
+void set_steady_state(bool steady) { g_steady = steady; }
+
+void set_log_level(int level) { g_log_level = level; }
+int get_log_level() { return g_log_level; }
+
+PreferenceStats preference_stats() { return Preference::stats; }
+void preferences_reset(bool keep_data) { g_preferences.reset(keep_data); }
+
+}  // namespace impulse_sim
+
+namespace esphome {
+
+Application App;  // NOLINT
+ESPPreferences *global_preferences = &impulse_sim::g_preferences;  // NOLINT
+
+namespace setup_priority {
+const float BUS = 1000.0f;
+const float IO = 900.0f;
+const float HARDWARE = 800.0f;
+const float DATA = 600.0f;
+const float PROCESSOR = 400.0f;
+const float AFTER_WIFI = 200.0f;
+const float LATE = -100.0f;
+}  // namespace setup_priority
+
+uint32_t millis() { return static_cast<uint32_t>(impulse_sim::now_us() / 1000); }
+uint32_t micros() { return static_cast<uint32_t>(impulse_sim::now_us()); }
+void delay(uint32_t ms) { impulse_sim::set_now_us(impulse_sim::now_us() + uint64_t(ms) * 1000); }
+
+void esp_log_printf_(int level, const char *tag, int line, const char *format, ...) {
+  // Always format, like the device logger does for enabled levels, so the
+  // benchmark sees the real cost of a log statement.
+  char buf[512];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  if (level > impulse_sim::g_log_level)
+    return;
+  static const char *const LETTERS = "-EWICDVX";
+  const uint64_t now = impulse_sim::now_us();
+  std::fprintf(stderr, "[%7llu.%03llu][%c][%s:%d]: %s\n", (unsigned long long) (now / 1000000),
+               (unsigned long long) ((now / 1000) % 1000), LETTERS[level], tag, line, buf);
+}
+
+uint32_t fnv1_hash(const std::string &str) {
+  uint32_t hash = 2166136261UL;
+  for (char c : str) {
+    hash *= 16777619UL;
+    hash ^= static_cast<uint8_t>(c);
+  }
+  return hash;
+}
+
+void EntityBase::set_name(const char *name) {
+  this->name_ = name;
+  this->object_id_hash_ = fnv1_hash(this->name_);
+}
+
+float Component::get_setup_priority() const { return setup_priority::DATA; }
+
+void Component::set_interval(const std::string &name, uint32_t interval, std::function<void()> &&f) {
+  impulse_sim::add_item(this, name, interval, interval, std::move(f));
+}
+void Component::set_interval(const char *name, uint32_t interval, std::function<void()> &&f) {
+  impulse_sim::add_item(this, name, interval, interval, std::move(f));
+}
+void Component::set_interval(uint32_t interval, std::function<void()> &&f) {
+  impulse_sim::add_item(this, "", interval, interval, std::move(f));
+}
+bool Component::cancel_interval(const std::string &name) { return impulse_sim::cancel_item(this, name, true); }
+bool Component::cancel_interval(const char *name) { return impulse_sim::cancel_item(this, name, true); }
+
+void Component::set_timeout(const std::string &name, uint32_t timeout, std::function<void()> &&f) {
+  impulse_sim::add_item(this, name, timeout, 0, std::move(f));
+}
+void Component::set_timeout(const char *name, uint32_t timeout, std::function<void()> &&f) {
+  impulse_sim::add_item(this, name, timeout, 0, std::move(f));
+}
+void Component::set_timeout(uint32_t timeout, std::function<void()> &&f) {
+  impulse_sim::add_item(this, "", timeout, 0, std::move(f));
+}
+bool Component::cancel_timeout(const std::string &name) { return impulse_sim::cancel_item(this, name, false); }
+bool Component::cancel_timeout(const char *name) { return impulse_sim::cancel_item(this, name, false); }
+
+void PollingComponent::call_setup() {
+  this->setup();
+  this->set_interval("update", this->update_interval_, [this]() { this->update(); });
+}
+
+namespace binary_sensor {
+
+void BinarySensor::publish_state(bool state) {
+  if (this->has_state_ && this->state == state)
+    return;
+  this->has_state_ = true;
+  this->state = state;
+  impulse_sim::ComponentScope scope;
+  this->state_callback_.call(state);
+}
+
+void BinarySensor::publish_initial_state(bool state) {
+  this->has_state_ = false;
+  this->publish_state(state);
+}
+
+}  // namespace binary_sensor
+
+namespace cover {
+
+const float COVER_OPEN = 1.0f;
+const float COVER_CLOSED = 0.0f;
+
+const char *cover_operation_to_str(CoverOperation op) {
+  switch (op) {
+    case COVER_OPERATION_IDLE:
+      return "IDLE";
+    case COVER_OPERATION_OPENING:
+      return "OPENING";
+    case COVER_OPERATION_CLOSING:
+      return "CLOSING";
+    default:
+      return "UNKNOWN";
+  }
+}
+
+CoverCall &CoverCall::set_command_open() {
+  this->position_ = COVER_OPEN;
+  return *this;
+}
+CoverCall &CoverCall::set_command_close() {
+  this->position_ = COVER_CLOSED;
+  return *this;
+}
+CoverCall &CoverCall::set_command_stop() {
+  this->stop_ = true;
+  return *this;
+}
+CoverCall &CoverCall::set_command_toggle() {
+  this->toggle_ = true;
+  return *this;
+}
+CoverCall &CoverCall::set_position(float position) {
+  this->position_ = position;
+  return *this;
+}
+CoverCall &CoverCall::set_stop(bool stop) {
+  this->stop_ = stop;
+  return *this;
+}
+
+void CoverCall::perform() {
+  if (this->position_.has_value())
+    this->position_ = clamp(*this->position_, 0.0f, 1.0f);
+  impulse_sim::ComponentScope scope;
+  this->parent_->control(*this);
+}
+
+CoverCall CoverRestoreState::to_call(Cover *cover) {
+  auto call = cover->make_call();
+  call.set_position(this->position);
+  return call;
+}
+
+void CoverRestoreState::apply(Cover *cover) {
+  cover->position = this->position;
+  cover->tilt = this->tilt;
+  cover->publish_state();
+}
+
+void Cover::publish_state(bool save) {
+  this->position = clamp(this->position, 0.0f, 1.0f);
+  this->tilt = clamp(this->tilt, 0.0f, 1.0f);
+  ESP_LOGD("cover", "'%s' - Publishing: Position: %.0f%% Operation: %s", this->name_.c_str(),
+           this->position * 100.0f, cover_operation_to_str(this->current_operation));
+  this->state_callback_.call();
+  if (save) {
+    CoverRestoreState restore{};
+    std::memset(&restore, 0, sizeof(restore));
+    restore.position = this->position;
+    this->rtc_.save(&restore);
+  }
+}
+
+optional<CoverRestoreState> Cover::restore_state_() {
+  this->rtc_ = global_preferences->make_preference<CoverRestoreState>(this->get_object_id_hash());
+  CoverRestoreState recovered{};
+  if (!this->rtc_.load(&recovered))
+    return {};
+  return recovered;
+}
+
+}  // namespace cover
+}  // namespace esphome
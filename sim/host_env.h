@@ -0,0 +1,46 @@
+#pragma once
+
+// Control surface of the host ESPHome stand-in (stubs/esphome/...). The
+// simulator owns time: nothing advances unless set_now_us() is called.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace impulse_sim {
+
+uint64_t now_us();
+// Never goes back: a component may not see time run backwards within a run
+void set_now_us(uint64_t now);
+// Back to time zero for the next run, with the scheduler and components reset
+void reset_now_us();
+
+// Scheduler (Component::set_timeout / set_interval)
+bool scheduler_next_due_us(uint64_t *due);
+void scheduler_run_due();
+size_t scheduler_pending();
+void scheduler_reset();
+
+// Component scope: held while the simulator runs component code (loop passes,
+// scheduler callbacks, sensor publishes, cover calls). After Simulator::setup()
+// the impulse_cover_sim heap audit counts the allocations made inside it.
+class ComponentScope {
+ public:
+  ComponentScope();
+  ~ComponentScope();
+};
+bool in_steady_component_scope();
+void set_steady_state(bool steady);
+
+// Logging: messages above this level are formatted but not printed.
+void set_log_level(int level);
+int get_log_level();
+
+// Preferences (in-memory flash)
+struct PreferenceStats {
+  uint32_t save_calls{0};   // ESPPreferenceObject::save() calls
+  uint32_t flash_writes{0}; // saves that changed the stored bytes
+};
+PreferenceStats preference_stats();
+void preferences_reset(bool keep_data);
+
+}  // namespace impulse_sim
@@ -0,0 +1,211 @@
+#pragma once
+
+// One simulated installation: gate physics, relay, endstop sensors and the
+// ImpulseCover under test, wired the way cover.py wires them on a device.
+
+#include "esphome/components/binary_sensor/binary_sensor.h"
+#include "esphome/components/sensor/sensor.h"
+#include "esphome/components/text_sensor/text_sensor.h"
+#include "gate_model.h"
+#include "impulse_cover/impulse_cover.h"
+#include "simulator.h"
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace impulse_sim {
+
+struct CoverSetup {
+  uint32_t open_duration_ms{15000};
+  uint32_t close_duration_ms{15000};
+  uint32_t pulse_delay_ms{500};
+  uint32_t safety_timeout_ms{60000};
+  uint8_t safety_max_cycles{5};
+  bool open_sensor{true};
+  bool close_sensor{true};
+  bool open_sensor_inverted{false};  // the TopologyCover reads the sensor inverted
+  bool close_sensor_inverted{false};
+  esphome::impulse_cover::MotionMode motion_mode{esphome::impulse_cover::MOTION_MODE_POLLING};
+  esphome::impulse_cover::TravelCurve *open_curve{nullptr};
+  esphome::impulse_cover::TravelCurve *close_curve{nullptr};
+  uint32_t stop_lead_ms{0};
+  bool learn_stop_lead{false};
+  bool learn_durations{false};
+  uint32_t min_save_interval_ms{60000};
+  float publish_min_delta{0.0f};
+  uint32_t publish_min_interval_ms{1000};
+  bool publish_transitions_only{false};
+  uint32_t publish_heartbeat_ms{0};
+  uint16_t trace_size{64};
+  uint32_t command_settle_ms{0};
+  bool edge_pins{false};  // open_sensor_pin / close_sensor_pin on the endstop contacts
+  uint32_t endstop_debounce_ms{10};
+  std::vector<int32_t> pulse_patterns[esphome::impulse_cover::PULSE_PATTERN_COUNT];  // ms, negative: pause
+  esphome::impulse_cover::ControllerProfile controller_profile{
+      esphome::impulse_cover::CONTROLLER_OPEN_STOP_CLOSE_STOP};
+  bool impulse_output{true};      // output on the impulse input
+  bool open_close_outputs{false};  // open_output / close_output on the dedicated inputs
+  bool stop_output{false};
+  std::vector<float> marks;       // position_sensors, one reed switch per position
+  float mark_band{0.005f};        // distance from its position a reed switch closes at
+  float encoder_counts{0.0f};     // encoder_counts_per_travel; 0 for no encoder
+  uint32_t encoder_interval_ms{100};
+  float current_threshold{0.0f};  // current_sensor with this current_threshold; 0 for none
+  float stall_threshold{0.0f};
+  uint32_t current_interval_ms{100};
+  uint32_t ack_timeout_ms{0};     // ack_timeout; 0 leaves presses unconfirmed
+  uint8_t ack_retries{2};
+};
+
+// The TopologyCover cover.py would generate for the setup's sensors
+template<bool O, bool C, bool OI, bool CI> esphome::impulse_cover::ImpulseCover *new_topology_cover() {
+  return new esphome::impulse_cover::TopologyCover<esphome::impulse_cover::SensorTopology<O, C, OI, CI>>();
+}
+
+inline esphome::impulse_cover::ImpulseCover *new_cover(const CoverSetup &setup) {
+  using Factory = esphome::impulse_cover::ImpulseCover *(*) ();
+  static const Factory FACTORIES[16] = {
+      new_topology_cover<false, false, false, false>, new_topology_cover<true, false, false, false>,
+      new_topology_cover<false, true, false, false>,  new_topology_cover<true, true, false, false>,
+      new_topology_cover<false, false, true, false>,  new_topology_cover<true, false, true, false>,
+      new_topology_cover<false, true, true, false>,   new_topology_cover<true, true, true, false>,
+      new_topology_cover<false, false, false, true>,  new_topology_cover<true, false, false, true>,
+      new_topology_cover<false, true, false, true>,   new_topology_cover<true, true, false, true>,
+      new_topology_cover<false, false, true, true>,   new_topology_cover<true, false, true, true>,
+      new_topology_cover<false, true, true, true>,    new_topology_cover<true, true, true, true>,
+  };
+  const bool open_inverted = setup.open_sensor && setup.open_sensor_inverted;
+  const bool close_inverted = setup.close_sensor && setup.close_sensor_inverted;
+  return FACTORIES[setup.open_sensor | setup.close_sensor << 1 | open_inverted << 2 | close_inverted << 3]();
+}
+
+class SimCover {
+ public:
+  SimCover(const char *name, const GateConfig &gate_config, const CoverSetup &setup, uint32_t seed = 1)
+      : setup(setup),
+        gate(gate_config, seed),
+        output(&this->gate),
+        open_output(&this->gate, GateInput::OPEN),
+        close_output(&this->gate, GateInput::CLOSE),
+        stop_output(&this->gate, GateInput::STOP),
+        cover_storage(new_cover(setup)),
+        cover(*this->cover_storage),
+        safety_trigger(&this->cover) {
+    this->cover.set_name(name);
+    this->open_sensor.set_name("open endstop");
+    this->close_sensor.set_name("close endstop");
+    if (setup.impulse_output)
+      this->cover.set_output(&this->output);
+    if (setup.open_close_outputs) {
+      this->cover.set_open_output(&this->open_output);
+      this->cover.set_close_output(&this->close_output);
+    }
+    if (setup.stop_output)
+      this->cover.set_stop_output(&this->stop_output);
+    this->cover.set_open_duration(setup.open_duration_ms);
+    this->cover.set_close_duration(setup.close_duration_ms);
+    this->cover.set_pulse_delay(setup.pulse_delay_ms);
+    for (uint8_t p = 0; p < esphome::impulse_cover::PULSE_PATTERN_COUNT; p++) {
+      for (int32_t step : setup.pulse_patterns[p])
+        this->cover.add_pulse_step(static_cast<esphome::impulse_cover::PulsePattern>(p), step > 0, std::abs(step));
+    }
+    this->cover.set_controller_profile(setup.controller_profile);
+    this->cover.set_safety_timeout(setup.safety_timeout_ms);
+    this->cover.set_safety_max_cycles(setup.safety_max_cycles);
+    this->cover.set_motion_mode(setup.motion_mode);
+    if (setup.open_curve != nullptr)
+      this->cover.set_open_curve(setup.open_curve);
+    if (setup.close_curve != nullptr)
+      this->cover.set_close_curve(setup.close_curve);
+    this->cover.set_open_stop_lead(setup.stop_lead_ms);
+    this->cover.set_close_stop_lead(setup.stop_lead_ms);
+    this->cover.set_learn_stop_lead(setup.learn_stop_lead);
+    this->cover.set_learn_durations(setup.learn_durations);
+    this->cover.set_min_save_interval(setup.min_save_interval_ms);
+    this->cover.set_publish_min_delta(setup.publish_min_delta);
+    this->cover.set_publish_min_interval(setup.publish_min_interval_ms);
+    this->cover.set_publish_transitions_only(setup.publish_transitions_only);
+    this->cover.set_publish_heartbeat(setup.publish_heartbeat_ms);
+    this->cover.set_trace_size(setup.trace_size);
+    this->cover.set_command_settle(setup.command_settle_ms);
+    this->cover.set_ack_timeout(setup.ack_timeout_ms);
+    this->cover.set_ack_retries(setup.ack_retries);
+    if (setup.edge_pins) {
+      this->cover.set_open_sensor_pin(&this->open_pin);
+      this->cover.set_close_sensor_pin(&this->close_pin);
+      this->cover.set_endstop_debounce(setup.endstop_debounce_ms);
+    }
+    for (uint8_t i = 0; i < esphome::impulse_cover::DIAGNOSTIC_SENSOR_COUNT; i++)
+      this->cover.set_diagnostic_sensor(static_cast<esphome::impulse_cover::DiagnosticSensor>(i),
+                                        &this->diagnostics[i]);
+    this->cover.set_eta_sensor(&this->eta);
+    this->cover.set_target_sensor(&this->target);
+    this->cover.set_trajectory_text_sensor(&this->trajectory);
+    if (setup.open_sensor)
+      this->cover.set_open_sensor(&this->open_sensor);
+    if (setup.close_sensor)
+      this->cover.set_close_sensor(&this->close_sensor);
+    for (float position : setup.marks) {
+      this->marks.emplace_back(new esphome::binary_sensor::BinarySensor());
+      this->marks.back()->set_name("position mark");
+      this->cover.add_position_mark(this->marks.back().get(), position);
+    }
+    if (setup.encoder_counts > 0.0f) {
+      this->encoder.set_name("encoder");
+      this->cover.set_encoder(&this->encoder, setup.encoder_counts);
+    }
+    if (setup.current_threshold > 0.0f) {
+      this->current.set_name("motor current");
+      this->cover.set_current_sensor(&this->current);
+      this->cover.set_current_threshold(setup.current_threshold);
+      this->cover.set_stall_threshold(setup.stall_threshold);
+    }
+    this->cover.add_on_safety_trigger(&this->safety_trigger);
+    this->cover.add_on_state_callback([this]() { this->publishes++; });
+  }
+
+  void attach(Simulator *sim) {
+    sim->add_gate(&this->gate, &this->open_sensor, &this->close_sensor, &this->open_pin, &this->close_pin);
+    for (size_t i = 0; i < this->marks.size(); i++)
+      sim->add_mark(&this->gate, this->setup.marks[i], this->setup.mark_band, this->marks[i].get());
+    if (this->setup.encoder_counts > 0.0f)
+      sim->add_encoder(&this->gate, &this->encoder, this->setup.encoder_counts, this->setup.encoder_interval_ms);
+    if (this->setup.current_threshold > 0.0f)
+      sim->add_current(&this->gate, &this->current, this->setup.current_interval_ms);
+    sim->add_component(&this->cover);
+  }
+
+  bool is_settled() const {
+    return this->cover.current_operation == esphome::cover::COVER_OPERATION_IDLE &&
+           this->gate.is_settled() && !this->output.get_state() && !this->open_output.get_state() &&
+           !this->close_output.get_state() && !this->stop_output.get_state();
+  }
+  uint32_t relay_pulses() const {
+    return this->output.get_rising_edges() + this->open_output.get_rising_edges() +
+           this->close_output.get_rising_edges() + this->stop_output.get_rising_edges();
+  }
+
+  CoverSetup setup;
+  GateModel gate;
+  SimOutput output;
+  SimOutput open_output;
+  SimOutput close_output;
+  SimOutput stop_output;
+  esphome::binary_sensor::BinarySensor open_sensor;
+  esphome::binary_sensor::BinarySensor close_sensor;
+  SimPin open_pin;
+  SimPin close_pin;
+  std::vector<std::unique_ptr<esphome::binary_sensor::BinarySensor>> marks;
+  esphome::sensor::Sensor encoder;
+  esphome::sensor::Sensor current;
+  std::unique_ptr<esphome::impulse_cover::ImpulseCover> cover_storage;
+  esphome::impulse_cover::ImpulseCover &cover;
+  esphome::impulse_cover::SafetyTrigger safety_trigger;
+  esphome::sensor::Sensor diagnostics[esphome::impulse_cover::DIAGNOSTIC_SENSOR_COUNT];
+  esphome::sensor::Sensor eta;
+  esphome::sensor::Sensor target;
+  esphome::text_sensor::TextSensor trajectory;
+  uint32_t publishes{0};
+};
+
+}  // namespace impulse_sim
@@ -0,0 +1,946 @@
+// Host simulation of ImpulseCover against a gate physics model.
+//
+//   impulse_cover_sim [--scenario partial|pedestrian|soak|drag|fleet|group|all] [--hours H] [--seed N]
+//                     [--loop-interval MS] [--loop-jitter MS] [--no-sensors] [--sensors both|open|close|none]
+//                     [--motion-mode polling|event] [--curve] [--stop-lead MS] [--learn-stop-lead]
+//                     [--learn-durations] [--min-save-interval MS]
+//                     [--publish-min-delta F] [--publish-min-interval MS]
+//                     [--publish-transitions-only] [--publish-heartbeat MS]
+//                     [--trace-size N] [--dump-trace] [--command-settle MS] [--covers N] [--hub]
+//                     [--edge-pins] [--endstop-debounce MS] [--sensor-delay MS] [--bounce MS]
+//                     [--max-moving N] [--pulse-spacing MS] [--inrush MS]
+//                     [--coast MS] [--start-delay MS] [--speed-open F] [--speed-close F]
+//                     [--soft-start MS] [--slowdown-zone F] [--miss-rate F] [--log-level N]
+//                     [--pulse-pattern NAME=MS,-MS,...] [--heap-audit]
+//                     [--controller open_stop_close_stop|open_stop_close|open_close_open]
+//                     [--direct-outputs open-close|all|only]
+//                     [--marks F,F,...] [--encoder COUNTS] [--encoder-interval MS]
+//                     [--current THRESHOLD] [--current-interval MS] [--stall-threshold A] [--obstacle F]
+//                     [--ack-timeout MS] [--ack-retries N]
+//
+// Reports final-position error (cover estimate minus physical position) and
+// command latency (control() call to first gate movement) per move.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "esphome/core/log.h"
+#include "heap_audit.h"
+#include "host_env.h"
+#include "impulse_cover_hub/impulse_cover_hub.h"
+#include "sim_cover.h"
+
+using namespace impulse_sim;
+using esphome::cover::COVER_OPERATION_IDLE;
+
+namespace {
+
+struct Options {
+  std::string scenario{"all"};
+  float hours{1.0f};
+  uint32_t seed{1};
+  SimConfig sim;
+  GateConfig gate;
+  CoverSetup cover;
+  int log_level{ESPHOME_LOG_LEVEL_ERROR};
+  bool curve{false};
+  bool dump_trace{false};
+  uint32_t covers{8};
+  bool hub{false};
+  uint8_t max_moving{0};
+  uint32_t pulse_spacing_ms{0};
+  uint32_t inrush_ms{0};
+  bool heap_audit{false};
+};
+
+struct MoveResult {
+  const char *label;
+  float target;
+  float cover_position;
+  float gate_position;
+  float gate_start;    // gate position when the command was issued
+  int32_t latency_ms;  // -1 if the gate never started
+  uint32_t settle_ms;
+  bool settled;
+  int32_t eta_ms;     // ETA published for the command, -1 if none
+  int32_t actual_ms;  // command to the gate coming to rest, -1 if it never moved
+};
+
+struct Summary {
+  std::vector<float> abs_errors;
+  std::vector<float> target_errors;  // physical landing vs requested, intermediate targets only
+  std::vector<int32_t> latencies;
+  std::vector<int32_t> eta_errors;  // published ETA vs the gate coming to rest
+  uint32_t unsettled{0};
+  uint32_t safety_trips{0};
+  uint32_t wrong_way{0};  // moves that left the gate further from the target than it started
+
+  void add(const MoveResult &r) {
+    this->abs_errors.push_back(std::fabs(r.cover_position - r.gate_position));
+    if (r.target > 0.0f && r.target < 1.0f)
+      this->target_errors.push_back(std::fabs(r.gate_position - r.target));
+    if (r.latency_ms >= 0)
+      this->latencies.push_back(r.latency_ms);
+    if (r.eta_ms > 0 && r.actual_ms >= 0)
+      this->eta_errors.push_back(std::abs(r.actual_ms - r.eta_ms));
+    if (!r.settled)
+      this->unsettled++;
+    if (r.target >= 0.0f && std::fabs(r.gate_position - r.target) > std::fabs(r.gate_start - r.target) + 0.01f)
+      this->wrong_way++;
+  }
+};
+
+template<typename T> T percentile(std::vector<T> values, float p) {
+  if (values.empty())
+    return T{};
+  std::sort(values.begin(), values.end());
+  size_t idx = static_cast<size_t>(p * (values.size() - 1) + 0.5f);
+  return values[idx];
+}
+
+template<typename T> double mean(const std::vector<T> &values) {
+  if (values.empty())
+    return 0.0;
+  double sum = 0.0;
+  for (auto v : values)
+    sum += v;
+  return sum / values.size();
+}
+
+// Issue one command and run until both the cover and the gate are at rest.
+template<typename F>
+MoveResult run_move(Simulator &sim, SimCover &unit, const char *label, float target, F &&command) {
+  const uint32_t starts_before = unit.gate.stats().motion_starts;
+  const uint32_t cmd_ms = sim.now_ms();
+  const uint32_t etas_before = unit.eta.get_publish_count();
+  const float gate_start = unit.gate.position();
+  command();
+
+  MoveResult r{label, target, 0, 0, gate_start, -1, 0, false, -1, -1};
+  if (unit.eta.get_publish_count() != etas_before)
+    r.eta_ms = static_cast<int32_t>(unit.eta.state * 1000.0f + 0.5f);
+  const uint32_t limit = unit.setup.open_duration_ms + unit.setup.close_duration_ms + 30000;
+  const uint32_t grace = 4 * unit.setup.pulse_delay_ms + unit.gate.config().coast_ms + 100;
+  while (sim.now_ms() - cmd_ms < limit) {
+    if (!sim.run_until([&]() { return unit.is_settled(); }, limit))
+      break;
+    sim.run_for(grace);  // pending pulses may still restart the gate
+    if (unit.is_settled()) {
+      r.settled = true;
+      break;
+    }
+  }
+  if (unit.gate.stats().motion_starts != starts_before) {
+    r.latency_ms = static_cast<int32_t>(unit.gate.stats().last_motion_start_ms - cmd_ms);
+    r.actual_ms = static_cast<int32_t>(unit.gate.stats().last_stop_ms - cmd_ms);
+  }
+  r.settle_ms = sim.now_ms() - cmd_ms;
+  r.cover_position = unit.cover.position;
+  r.gate_position = unit.gate.position();
+  return r;
+}
+
+void print_move(const MoveResult &r) {
+  std::printf("  %-10s target=%5.3f cover=%5.3f gate=%5.3f error=%+7.4f latency=%5dms settle=%6ums%s\n",
+              r.label, r.target, r.cover_position, r.gate_position, r.cover_position - r.gate_position,
+              r.latency_ms, r.settle_ms, r.settled ? "" : " (UNSETTLED)");
+}
+
+void print_summary(const char *name, const Summary &s, const SimCover &unit, const Simulator &sim,
+                   double wall_s) {
+  const auto prefs = preference_stats();
+  std::printf("\n== %s summary ==\n", name);
+  std::printf("  simulated_time_s        %.1f\n", sim.now_ms() / 1000.0);
+  std::printf("  wall_time_s             %.3f\n", wall_s);
+  std::printf("  moves                   %zu (unsettled %u)\n", s.abs_errors.size(), s.unsettled);
+  std::printf("  final_error_mean        %.4f\n", mean(s.abs_errors));
+  std::printf("  final_error_p95         %.4f\n", percentile(s.abs_errors, 0.95f));
+  std::printf("  final_error_max         %.4f\n", percentile(s.abs_errors, 1.0f));
+  std::printf("  landing_error_p50       %.4f\n", percentile(s.target_errors, 0.5f));
+  std::printf("  landing_error_p95       %.4f\n", percentile(s.target_errors, 0.95f));
+  std::printf("  latency_mean_ms         %.1f\n", mean(s.latencies));
+  std::printf("  latency_p95_ms          %d\n", percentile(s.latencies, 0.95f));
+  std::printf("  eta_error_p50_ms        %d\n", percentile(s.eta_errors, 0.5f));
+  std::printf("  eta_error_p95_ms        %d\n", percentile(s.eta_errors, 0.95f));
+  std::printf("  relay_pulses            %u\n", unit.relay_pulses());
+  std::printf("  presses_accepted        %u\n", unit.gate.stats().presses_accepted);
+  std::printf("  presses_missed          %u\n", unit.gate.stats().presses_missed);
+  std::printf("  safety_trips            %u\n", s.safety_trips);
+  std::printf("  wrong_way_moves         %u\n", s.wrong_way);
+  std::printf("  stop_lead_ms            open %.0f, close %.0f\n", unit.cover.get_open_stop_lead(),
+              unit.cover.get_close_stop_lead());
+  std::printf("  durations_ms            open %u, close %u\n", unit.cover.get_open_duration(),
+              unit.cover.get_close_duration());
+  std::printf("  state_publishes         %u\n", unit.publishes);
+  std::printf("  trajectory_publishes    %u\n", unit.trajectory.get_publish_count());
+  std::printf("  preference_saves        %u\n", prefs.save_calls);
+  std::printf("  preference_writes       %u\n", prefs.flash_writes);
+  std::printf("  cover_state_saves       %u (coalesced %u)\n", unit.cover.get_state_saves(),
+              unit.cover.get_state_saves_coalesced());
+  const auto &stats = unit.cover.get_stats();
+  std::printf("  cover_pulses            %u (double %u, deferred %u)\n", stats.pulses, stats.double_pulses,
+              stats.deferred_pulses);
+  std::printf("  cover_safety_trips      %u\n", stats.safety_trips);
+  std::printf("  cover_coalesced         %u\n", stats.coalesced_commands);
+  std::printf("  cover_corrections       %u\n", stats.corrections);
+  std::printf("  cover_endstop_arrivals  %u\n", stats.endstop_arrivals);
+  std::printf("  cover_command_latency   p50 %u, p95 %u, max %u ms\n", stats.command_latency.percentile(0.5f),
+              stats.command_latency.percentile(0.95f), stats.command_latency.max());
+  std::printf("  cover_pulse_jitter      p50 %u, p95 %u, max %u ms\n", stats.pulse_jitter.percentile(0.5f),
+              stats.pulse_jitter.percentile(0.95f), stats.pulse_jitter.max());
+  std::printf("  cover_arrival_error     p50 %u, p95 %u, max %u ms\n", stats.arrival_error.percentile(0.5f),
+              stats.arrival_error.percentile(0.95f), stats.arrival_error.max());
+  std::printf("  cover_endstop_delay     p50 %u, p95 %u, max %u ms (n=%u)\n", stats.endstop_delay.percentile(0.5f),
+              stats.endstop_delay.percentile(0.95f), stats.endstop_delay.max(), stats.endstop_delay.count());
+  std::printf("  cover_missed_presses    %u\n", stats.missed_presses);
+  std::printf("  cover_ack_latency       p50 %u, p95 %u, max %u ms (n=%u)\n", stats.ack_latency.percentile(0.5f),
+              stats.ack_latency.percentile(0.95f), stats.ack_latency.max(), stats.ack_latency.count());
+  std::printf("  loop_passes             %llu\n", (unsigned long long) sim.get_loop_passes());
+  std::printf("  component_loop_calls    %llu\n", (unsigned long long) sim.get_component_loops());
+}
+
+// Logs the cover's event trace to stderr, for impulse_cover_trace.
+void dump_trace(const Options &opt, SimCover &unit) {
+  if (!opt.dump_trace)
+    return;
+  set_log_level(std::max(opt.log_level, ESPHOME_LOG_LEVEL_INFO));
+  unit.cover.dump_trace();
+  set_log_level(opt.log_level);
+}
+
+void reset_env() {
+  reset_now_us();
+  scheduler_reset();
+  preferences_reset(false);
+}
+
+// A scenario that issued no command measured nothing; it fails rather than
+// report an empty summary as a pass.
+bool check_ran(const char *name, size_t commands) {
+  if (commands == 0)
+    std::fprintf(stderr, "%s: no commands ran\n", name);
+  return commands > 0;
+}
+
+// A move that ends further from its target than it started went the wrong way,
+// as when the cycle safety stops a plan part way through.
+bool check_direction(const char *name, const Summary &s) {
+  if (s.wrong_way > 0)
+    std::fprintf(stderr, "%s: %u move(s) went the wrong way\n", name, s.wrong_way);
+  return s.wrong_way == 0;
+}
+
+struct Step {
+  const char *label;
+  float target;  // < 0 means stop
+};
+
+bool scenario_partial(const Options &opt) {
+  std::printf("== partial: intermediate targets from closed ==\n");
+  reset_env();
+  Simulator sim(opt.sim);
+  SimCover unit("Gate", opt.gate, opt.cover, opt.seed);
+  unit.attach(&sim);
+  sim.setup();
+  sim.run_for(1000);
+
+  static const Step STEPS[] = {
+      {"open", 1.0f}, {"close", 0.0f}, {"pos", 0.3f}, {"pos", 0.7f}, {"pos", 0.4f},
+      {"pos", 0.2f},  {"open", 1.0f},  {"pos", 0.5f}, {"pos", 0.8f}, {"close", 0.0f},
+  };
+  Summary s;
+  for (const auto &step : STEPS) {
+    auto r = run_move(sim, unit, step.label, step.target, [&]() {
+      unit.cover.make_call().set_position(step.target).perform();
+    });
+    print_move(r);
+    s.add(r);
+    if (unit.cover.is_safety_triggered()) {
+      s.safety_trips++;
+      unit.cover.reset_safety_mode();
+    }
+    sim.run_for(2000);
+  }
+  sim.shutdown();
+  dump_trace(opt, unit);
+  print_summary("partial", s, unit, sim, 0.0);
+  return check_ran("partial", s.abs_errors.size()) && check_direction("partial", s);
+}
+
+// Partial openings from the endstops (a pedestrian gap and its mirror), each
+// followed by a full run back: only single pulses, so landing error is down to
+// the stop timing, and every run back measures where the previous stop came to rest.
+bool scenario_pedestrian(const Options &opt) {
+  std::printf("\n== pedestrian: partial openings from the endstops ==\n");
+  reset_env();
+  Simulator sim(opt.sim);
+  SimCover unit("Gate", opt.gate, opt.cover, opt.seed);
+  unit.attach(&sim);
+  sim.setup();
+  sim.run_for(1000);
+
+  static const Step CYCLE[] = {{"pos", 0.3f}, {"close", 0.0f}, {"open", 1.0f},
+                               {"pos", 0.7f}, {"open", 1.0f},  {"close", 0.0f}};
+  Summary s;
+  for (int i = 0; i < 12; i++) {
+    for (const auto &step : CYCLE) {
+      // The cycle count only clears on reset_safety and a cycle sends more pulses
+      // than safety_max_cycles allows; clear it the way an automation would
+      unit.cover.reset_safety_mode();
+      auto r = run_move(sim, unit, step.label, step.target, [&]() {
+        unit.cover.make_call().set_position(step.target).perform();
+      });
+      if (i == 0 || i == 11 || opt.log_level >= ESPHOME_LOG_LEVEL_INFO)
+        print_move(r);
+      s.add(r);
+      sim.run_for(2000);
+    }
+  }
+  sim.shutdown();
+  dump_trace(opt, unit);
+  print_summary("pedestrian", s, unit, sim, 0.0);
+  return check_ran("pedestrian", s.abs_errors.size()) && check_direction("pedestrian", s);
+}
+
+// Slider drags: bursts of position commands 120 ms apart that start the wrong
+// way, overshoot the final value and come back to it, as a UI sends them while
+// the user drags. Reports the landing error p95 and the coalesced commands.
+bool scenario_drag(const Options &opt, float *landing_p95, uint32_t *coalesced) {
+  std::printf("\n== drag: position bursts from a slider ==\n");
+  reset_env();
+  Simulator sim(opt.sim);
+  SimCover unit("Gate", opt.gate, opt.cover, opt.seed);
+  unit.attach(&sim);
+  sim.setup();
+  sim.run_for(1000);
+
+  static const float PATH[] = {-0.15f, 0.2f, 0.6f, 1.15f, 1.05f, 1.0f};
+  std::mt19937 rng(opt.seed);
+  std::uniform_int_distribution<int> target_dist(2, 18);
+  Summary s;
+  for (int i = 0; i < 40; i++) {
+    const float from = unit.cover.position;
+    const float target = target_dist(rng) / 20.0f;
+    auto r = run_move(sim, unit, "drag", target, [&]() {
+      for (float step : PATH) {
+        const float value = std::min(1.0f, std::max(0.0f, from + (target - from) * step));
+        unit.cover.make_call().set_position(std::round(value * 100.0f) / 100.0f).perform();
+        sim.run_for(120);
+      }
+    });
+    if (opt.log_level >= ESPHOME_LOG_LEVEL_INFO)
+      print_move(r);
+    s.add(r);
+    if (unit.cover.is_safety_triggered()) {
+      s.safety_trips++;
+      unit.cover.reset_safety_mode();
+    }
+    sim.run_for(40000);  // past the cycle count auto-reset
+  }
+  sim.shutdown();
+  dump_trace(opt, unit);
+  print_summary("drag", s, unit, sim, 0.0);
+  *landing_p95 = percentile(s.target_errors, 0.95f);
+  *coalesced = unit.cover.get_stats().coalesced_commands;
+  return check_ran("drag", s.abs_errors.size());
+}
+
+// The drags without and with command_settle (400 ms unless given): the window
+// must coalesce the bursts and land them no worse than acting on each command.
+bool scenario_drag_settle(const Options &opt) {
+  Options plain = opt;
+  plain.cover.command_settle_ms = 0;
+  Options settle = opt;
+  if (settle.cover.command_settle_ms == 0)
+    settle.cover.command_settle_ms = 400;
+  float plain_p95 = 0.0f, settle_p95 = 0.0f;
+  uint32_t plain_coalesced = 0, settle_coalesced = 0;
+  bool ok = scenario_drag(plain, &plain_p95, &plain_coalesced);
+  ok &= scenario_drag(settle, &settle_p95, &settle_coalesced);
+  std::printf("\n== drag: command_settle 0 vs %ums ==\n", settle.cover.command_settle_ms);
+  std::printf("  landing_error_p95       %.4f -> %.4f\n", plain_p95, settle_p95);
+  std::printf("  cover_coalesced         %u -> %u\n", plain_coalesced, settle_coalesced);
+  if (settle_coalesced == 0) {
+    std::fprintf(stderr, "drag: command_settle coalesced no command\n");
+    ok = false;
+  }
+  if (settle_p95 > plain_p95 + 0.01f) {
+    std::fprintf(stderr, "drag: command_settle raised the landing error p95\n");
+    ok = false;
+  }
+  return ok;
+}
+
+bool scenario_soak(const Options &opt, uint32_t *missed) {
+  std::printf("\n== soak: %.2f h of random commands ==\n", opt.hours);
+  reset_env();
+  Simulator sim(opt.sim);
+  SimCover unit("Gate", opt.gate, opt.cover, opt.seed);
+  unit.attach(&sim);
+  sim.setup();
+  sim.run_for(1000);
+
+  std::mt19937 rng(opt.seed);
+  std::uniform_real_distribution<float> unit_dist(0.0f, 1.0f);
+  std::uniform_int_distribution<uint32_t> idle_dist(2000, 60000);
+  const uint64_t end_ms = static_cast<uint64_t>(opt.hours * 3600000.0f);
+
+  Summary s;
+  const auto wall_start = std::chrono::steady_clock::now();
+  while (sim.now_ms() < end_ms) {
+    const float roll = unit_dist(rng);
+    MoveResult r;
+    if (roll < 0.6f) {
+      const float target = std::round(unit_dist(rng) * 20.0f) / 20.0f;
+      r = run_move(sim, unit, "pos", target, [&]() { unit.cover.make_call().set_position(target).perform(); });
+    } else if (roll < 0.75f) {
+      r = run_move(sim, unit, "open", 1.0f, [&]() { unit.cover.make_call().set_command_open().perform(); });
+    } else if (roll < 0.9f) {
+      r = run_move(sim, unit, "close", 0.0f, [&]() { unit.cover.make_call().set_command_close().perform(); });
+    } else {
+      // Interrupt a move half way with a stop.
+      const float target = unit.cover.position < 0.5f ? 1.0f : 0.0f;
+      unit.cover.make_call().set_position(target).perform();
+      sim.run_for(static_cast<uint32_t>(unit_dist(rng) * 8000.0f) + 500);
+      r = run_move(sim, unit, "stop", -1.0f, [&]() { unit.cover.make_call().set_command_stop().perform(); });
+    }
+    s.add(r);
+    if (opt.log_level >= ESPHOME_LOG_LEVEL_INFO)
+      print_move(r);
+    if (unit.cover.is_safety_triggered()) {
+      s.safety_trips++;
+      unit.cover.reset_safety_mode();
+    }
+    sim.run_for(idle_dist(rng));
+  }
+  const double wall_s =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+  sim.shutdown();
+  dump_trace(opt, unit);
+  print_summary("soak", s, unit, sim, wall_s);
+  *missed = unit.cover.get_stats().missed_presses;
+  return check_ran("soak", s.abs_errors.size());
+}
+
+// The soak for at least 24 h with no endstops, the motor current acknowledging
+// presses (1500 ms unless --ack-timeout is given) and a gate that misses none:
+// every press the cover takes as missed is a false alarm, and its retry a press too many.
+bool scenario_soak_ack(const Options &opt) {
+  Options ack = opt;
+  ack.hours = std::max(opt.hours, 24.0f);
+  ack.cover.open_sensor = ack.cover.close_sensor = false;
+  if (ack.cover.current_threshold <= 0.0f)
+    ack.cover.current_threshold = 1.0f;
+  if (ack.cover.ack_timeout_ms == 0)
+    ack.cover.ack_timeout_ms = 1500;
+  ack.gate.pulse_miss_probability = 0.0f;
+  uint32_t missed = 0;
+  bool ok = scenario_soak(ack, &missed);
+  if (missed > 0) {
+    std::fprintf(stderr, "soak: %u press(es) taken as missed by a gate that misses none\n", missed);
+    ok = false;
+  }
+  return ok;
+}
+
+// Time a full endstop-to-endstop run of a standalone copy of the gate, from
+// the press to the endstop, and sample it into curve points the way a user
+// would from a stopwatch. Returns the run duration.
+uint32_t profile_run(const GateConfig &gate_config, bool opening, esphome::impulse_cover::TravelCurve *curve) {
+  static const int POINTS = 8;
+  GateConfig config = gate_config;
+  config.initial_position = opening ? 0.0f : 1.0f;
+  config.pulse_miss_probability = 0.0f;
+  GateModel gate(config);
+
+  std::vector<float> progress;
+  uint32_t t = 0;
+  gate.set_input(true, t);
+  while (t < 10 * (config.open_time_ms + config.close_time_ms)) {
+    t++;
+    if (t == 2 * config.input_min_width_ms)
+      gate.set_input(false, t);
+    gate.step(t);
+    progress.push_back(opening ? gate.position() : 1.0f - gate.position());
+    if (t > 2 * config.input_min_width_ms && !gate.is_moving() && progress.back() >= 1.0f)
+      break;
+  }
+  for (int i = 1; i < POINTS; i++) {
+    const size_t idx = progress.size() * i / POINTS;
+    curve->add_point(float(i) / POINTS, progress[idx]);
+  }
+  return t;
+}
+
+// "double=500,-1000,500": pattern name, then step durations in ms, negative for a pause
+bool parse_pulse_pattern(const char *value, CoverSetup &cover) {
+  static const char *const NAMES[esphome::impulse_cover::PULSE_PATTERN_COUNT] = {"single", "double", "stop"};
+  const char *steps = std::strchr(value, '=');
+  if (steps == nullptr)
+    return false;
+  for (uint8_t p = 0; p < esphome::impulse_cover::PULSE_PATTERN_COUNT; p++) {
+    if (std::strncmp(value, NAMES[p], steps - value) != 0 || NAMES[p][steps - value] != '\0')
+      continue;
+    cover.pulse_patterns[p].clear();
+    char *end = const_cast<char *>(steps);
+    do {
+      cover.pulse_patterns[p].push_back(std::strtol(end + 1, &end, 10));
+    } while (*end == ',');
+    return *end == '\0';
+  }
+  return false;
+}
+
+bool parse_marks(const char *value, CoverSetup &cover) {
+  cover.marks.clear();
+  char *end = const_cast<char *>(value) - 1;
+  do {
+    const float position = std::strtof(end + 1, &end);
+    if (position <= 0.0f || position >= 1.0f)
+      return false;
+    cover.marks.push_back(position);
+  } while (*end == ',');
+  return *end == '\0';
+}
+
+bool parse_args(int argc, char **argv, Options &opt) {
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    auto next = [&]() -> const char * {
+      if (i + 1 >= argc) {
+        std::fprintf(stderr, "Missing value for %s\n", arg);
+        std::exit(2);
+      }
+      return argv[++i];
+    };
+    if (!std::strcmp(arg, "--scenario")) {
+      opt.scenario = next();
+    } else if (!std::strcmp(arg, "--hours")) {
+      opt.hours = std::strtof(next(), nullptr);
+    } else if (!std::strcmp(arg, "--seed")) {
+      opt.seed = std::strtoul(next(), nullptr, 10);
+    } else if (!std::strcmp(arg, "--loop-interval")) {
+      opt.sim.loop_interval_ms = std::strtoul(next(), nullptr, 10);
+    } else if (!std::strcmp(arg, "--loop-jitter")) {
+      opt.sim.loop_jitter_ms = std::strtoul(next(), nullptr, 10);
+    } else if (!std::strcmp(arg, "--no-sensors")) {
+      opt.cover.open_sensor = opt.cover.close_sensor = false;
+    } else if (!std::strcmp(arg, "--sensors")) {
+      const char *sensors = next();
+      opt.cover.open_sensor = !std::strcmp(sensors, "both") || !std::strcmp(sensors, "open");
+      opt.cover.close_sensor = !std::strcmp(sensors, "both") || !std::strcmp(sensors, "close");
+    } else if (!std::strcmp(arg, "--pulse-pattern")) {
+      const char *pattern = next();
+      if (!parse_pulse_pattern(pattern, opt.cover)) {
+        std::fprintf(stderr, "Bad pulse pattern: %s\n", pattern);
+        return false;
+      }
+    } else if (!std::strcmp(arg, "--controller")) {
+      // The gate runs the cycle the cover is told about
+      static const char *const NAMES[] = {"open_stop_close_stop", "open_stop_close", "open_close_open"};
+      const char *name = next();
+      uint8_t profile = 0;
+      while (profile < 3 && std::strcmp(name, NAMES[profile]) != 0)
+        profile++;
+      if (profile == 3) {
+        std::fprintf(stderr, "Unknown controller: %s\n", name);
+        return false;
+      }
+      opt.cover.controller_profile = static_cast<esphome::impulse_cover::ControllerProfile>(profile);
+      opt.gate.cycle = static_cast<GateCycle>(profile);
+    } else if (!std::strcmp(arg, "--direct-outputs")) {
+      // open-close: stops on the impulse output; all: stop output too; only: no impulse output
+      const char *outputs = next();
+      if (std::strcmp(outputs, "open-close") != 0 && std::strcmp(outputs, "all") != 0 &&
+          std::strcmp(outputs, "only") != 0) {
+        std::fprintf(stderr, "Unknown direct outputs: %s\n", outputs);
+        return false;
+      }
+      opt.cover.open_close_outputs = true;
+      opt.cover.stop_output = std::strcmp(outputs, "open-close") != 0;
+      opt.cover.impulse_output = std::strcmp(outputs, "only") != 0;
+    } else if (!std::strcmp(arg, "--marks")) {
+      // Reed switches between the endstops, as fractions of travel
+      const char *marks = next();
+      if (!parse_marks(marks, opt.cover)) {
+        std::fprintf(stderr, "Bad marks: %s\n", marks);
+        return false;
+      }
+    } else if (!std::strcmp(arg, "--encoder")) {
+      opt.cover.encoder_counts = std::strtof(next(), nullptr);
+    } else if (!std::strcmp(arg, "--encoder-interval")) {
+      opt.cover.encoder_interval_ms = std::strtoul(next(), nullptr, 10);
+    } else if (!std::strcmp(arg, "--current")) {
+      opt.cover.current_threshold = std::strtof(next(), nullptr);
+    } else if (!std::strcmp(arg, "--current-interval")) {
+      opt.cover.current_interval_ms = std::strtoul(next(), nullptr, 10);
+    } else if (!std::strcmp(arg, "--stall-threshold")) {
+      opt.cover.stall_threshold = std::strtof(next(), nullptr);
+    } else if (!std::strcmp(arg, "--obstacle")) {
+      opt.gate.obstacle = std::strtof(next(), nullptr);
+    } else if (!std::strcmp(arg, "--ack-timeout")) {
+      opt.cover.ack_timeout_ms = std::strtoul(next(), nullptr, 10);
+    } else if (!std::strcmp(arg, "--ack-retries")) {
+      opt.cover.ack_retries = static_cast<uint8_t>(std::strtoul(next(), nullptr, 10));
+    } else if (!std::strcmp(arg, "--motion-mode")) {
+      const char *mode = next();
+      opt.cover.motion_mode = !std::strcmp(mode, "event") ? esphome::impulse_cover::MOTION_MODE_EVENT
+                                                          : esphome::impulse_cover::MOTION_MODE_POLLING;
+    } else if (!std::strcmp(arg, "--curve")) {
+      opt.curve = true;
+    } else if (!std::strcmp(arg, "--stop-lead")) {
+      opt.cover.stop_lead_ms = std::strtoul(next(), nullptr, 10);
+    } else if (!std::strcmp(arg, "--learn-stop-lead")) {
+      opt.cover.learn_stop_lead = true;
+    } else if (!std::strcmp(arg, "--learn-durations")) {
+      opt.cover.learn_durations = true;
+    } else if (!std::strcmp(arg, "--min-save-interval")) {
+      opt.cover.min_save_interval_ms = std::strtoul(next(), nullptr, 10);
+    } else if (!std::strcmp(arg, "--publish-min-delta")) {
+      opt.cover.publish_min_delta = std::strtof(next(), nullptr);
+    } else if (!std::strcmp(arg, "--publish-min-interval")) {
+      opt.cover.publish_min_interval_ms = std::strtoul(next(), nullptr, 10);
+    } else if (!std::strcmp(arg, "--publish-transitions-only")) {
+      opt.cover.publish_transitions_only = true;
+    } else if (!std::strcmp(arg, "--publish-heartbeat")) {
+      opt.cover.publish_heartbeat_ms = std::strtoul(next(), nullptr, 10);
+    } else if (!std::strcmp(arg, "--trace-size")) {
+      opt.cover.trace_size = std::atoi(next());
+    } else if (!std::strcmp(arg, "--edge-pins")) {
+      opt.cover.edge_pins = true;
+    } else if (!std::strcmp(arg, "--endstop-debounce")) {
+      opt.cover.endstop_debounce_ms = std::atoi(next());
+    } else if (!std::strcmp(arg, "--sensor-delay")) {
+      opt.sim.sensor_delay_ms = std::atoi(next());
+    } else if (!std::strcmp(arg, "--bounce")) {
+      opt.sim.bounce_ms = std::atoi(next());
+    } else if (!std::strcmp(arg, "--command-settle")) {
+      opt.cover.command_settle_ms = std::atoi(next());
+    } else if (!std::strcmp(arg, "--covers")) {
+      opt.covers = std::max(1, std::atoi(next()));
+    } else if (!std::strcmp(arg, "--hub")) {
+      opt.hub = true;
+    } else if (!std::strcmp(arg, "--max-moving")) {
+      opt.max_moving = static_cast<uint8_t>(std::atoi(next()));
+    } else if (!std::strcmp(arg, "--pulse-spacing")) {
+      opt.pulse_spacing_ms = std::atoi(next());
+    } else if (!std::strcmp(arg, "--inrush")) {
+      opt.inrush_ms = std::atoi(next());
+    } else if (!std::strcmp(arg, "--dump-trace")) {
+      opt.dump_trace = true;
+    } else if (!std::strcmp(arg, "--coast")) {
+      opt.gate.coast_ms = std::strtoul(next(), nullptr, 10);
+    } else if (!std::strcmp(arg, "--start-delay")) {
+      opt.gate.motor_start_delay_ms = std::strtoul(next(), nullptr, 10);
+    } else if (!std::strcmp(arg, "--speed-open")) {
+      opt.gate.speed_factor_open = std::strtof(next(), nullptr);
+    } else if (!std::strcmp(arg, "--speed-close")) {
+      opt.gate.speed_factor_close = std::strtof(next(), nullptr);
+    } else if (!std::strcmp(arg, "--soft-start")) {
+      opt.gate.soft_start_ms = std::strtoul(next(), nullptr, 10);
+    } else if (!std::strcmp(arg, "--slowdown-zone")) {
+      opt.gate.slowdown_zone = std::strtof(next(), nullptr);
+    } else if (!std::strcmp(arg, "--miss-rate")) {
+      opt.gate.pulse_miss_probability = std::strtof(next(), nullptr);
+    } else if (!std::strcmp(arg, "--log-level")) {
+      opt.log_level = std::atoi(next());
+    } else if (!std::strcmp(arg, "--heap-audit")) {
+      opt.heap_audit = true;
+    } else {
+      std::fprintf(stderr, "Unknown option: %s\n", arg);
+      return false;
+    }
+  }
+  opt.sim.seed = opt.seed;
+  return true;
+}
+
+}  // namespace
+
+// Several covers on one node taking overlapping random commands. Reports the
+// component loop() calls it took in loop_calls.
+bool scenario_fleet(const Options &opt, uint64_t *loop_calls) {
+  std::printf("\n== fleet: %u covers, %.2f h of overlapping commands%s ==\n", opt.covers, opt.hours,
+              opt.hub ? " (hub)" : "");
+  reset_env();
+  Simulator sim(opt.sim);
+  esphome::impulse_cover_hub::ImpulseCoverHub hub;
+  std::vector<std::unique_ptr<SimCover>> units;
+  std::vector<std::string> names;
+  for (uint32_t i = 0; i < opt.covers; i++)
+    names.push_back("Cover " + std::to_string(i));
+  for (uint32_t i = 0; i < opt.covers; i++) {
+    units.emplace_back(new SimCover(names[i].c_str(), opt.gate, opt.cover, opt.seed + i));
+    if (opt.hub) {
+      units.back()->cover.set_hub(&hub);
+      hub.register_cover(&units.back()->cover);
+    }
+    units.back()->attach(&sim);
+  }
+  if (opt.hub)
+    sim.add_component(&hub);
+  sim.setup();
+  sim.run_for(1000);
+
+  std::mt19937 rng(opt.seed);
+  std::uniform_real_distribution<float> unit_dist(0.0f, 1.0f);
+  std::uniform_int_distribution<uint32_t> cover_dist(0, opt.covers - 1);
+  std::uniform_int_distribution<uint32_t> gap_dist(500, 20000);
+  const uint64_t end_ms = static_cast<uint64_t>(opt.hours * 3600000.0f);
+  const uint64_t loops_before = sim.get_component_loops();
+  size_t max_moving = 0;
+  uint32_t commands = 0;
+
+  const auto wall_start = std::chrono::steady_clock::now();
+  while (sim.now_ms() < end_ms) {
+    SimCover &unit = *units[cover_dist(rng)];
+    if (unit.cover.is_safety_triggered())
+      unit.cover.reset_safety_mode();
+    const float target = std::round(unit_dist(rng) * 4.0f) / 4.0f;
+    unit.cover.make_call().set_position(target).perform();
+    commands++;
+    uint32_t gap = gap_dist(rng);
+    while (gap > 0) {
+      const uint32_t step = std::min<uint32_t>(gap, 250);
+      sim.run_for(step);
+      gap -= step;
+      max_moving = std::max(max_moving, hub.get_moving_count());
+    }
+  }
+  sim.run_until([&]() {
+    return std::all_of(units.begin(), units.end(), [](const std::unique_ptr<SimCover> &u) { return u->is_settled(); });
+  }, 120000);
+  const double wall_s =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
+  std::vector<float> errors;
+  uint64_t moving_loops = 0;
+  for (auto &unit : units) {
+    errors.push_back(std::fabs(unit->cover.position - unit->gate.position()));
+    moving_loops += unit->cover.get_stats().loop_time.count();
+  }
+  std::printf("\n== fleet summary ==\n");
+  std::printf("  simulated_time_s        %.1f\n", sim.now_ms() / 1000.0);
+  std::printf("  wall_time_s             %.3f\n", wall_s);
+  std::printf("  commands                %u\n", commands);
+  std::printf("  final_error_mean        %.4f\n", mean(errors));
+  std::printf("  final_error_max         %.4f\n", percentile(errors, 1.0f));
+  std::printf("  component_loop_calls    %llu\n", (unsigned long long) (sim.get_component_loops() - loops_before));
+  std::printf("  cover_moving_loops      %llu\n", (unsigned long long) moving_loops);
+  if (opt.hub)
+    std::printf("  hub_max_moving          %zu\n", max_moving);
+  *loop_calls = sim.get_component_loops() - loops_before;
+  return check_ran("fleet", commands);
+}
+
+// The same fleet without and with the hub: the hub must cut the loop() calls.
+bool scenario_fleet_hub(const Options &opt) {
+  Options plain = opt;
+  plain.hub = false;
+  Options hub = opt;
+  hub.hub = true;
+  uint64_t plain_calls = 0, hub_calls = 0;
+  bool ok = scenario_fleet(plain, &plain_calls);
+  ok &= scenario_fleet(hub, &hub_calls);
+  std::printf("\n== fleet: hub vs no hub ==\n");
+  std::printf("  component_loop_calls    %llu -> %llu\n", (unsigned long long) plain_calls,
+              (unsigned long long) hub_calls);
+  if (hub_calls >= plain_calls) {
+    std::fprintf(stderr, "fleet: the hub did not cut component loop calls\n");
+    ok = false;
+  }
+  return ok;
+}
+
+// "Close everything": every cover open, then one group close. Without --hub the
+// covers are closed in the same pass, as a plain automation would.
+bool scenario_group(const Options &opt) {
+  std::printf("\n== group: close %u open covers%s ==\n", opt.covers, opt.hub ? " (hub)" : "");
+  reset_env();
+  Simulator sim(opt.sim);
+  esphome::impulse_cover_hub::ImpulseCoverHub hub;
+  hub.set_max_moving(opt.max_moving);
+  hub.set_pulse_spacing(opt.pulse_spacing_ms);
+  hub.set_inrush_time(opt.inrush_ms);
+  std::vector<std::unique_ptr<SimCover>> units;
+  std::vector<std::string> names;
+  for (uint32_t i = 0; i < opt.covers; i++)
+    names.push_back("Cover " + std::to_string(i));
+  for (uint32_t i = 0; i < opt.covers; i++) {
+    // Run times from 0.6x to 1.4x the configured ones, so start order matters
+    const float scale = opt.covers > 1 ? 0.6f + 0.8f * i / (opt.covers - 1) : 1.0f;
+    GateConfig gate = opt.gate;
+    gate.open_time_ms = static_cast<uint32_t>(gate.open_time_ms * scale);
+    gate.close_time_ms = static_cast<uint32_t>(gate.close_time_ms * scale);
+    gate.initial_position = 1.0f;
+    CoverSetup setup = opt.cover;
+    setup.open_duration_ms = static_cast<uint32_t>(setup.open_duration_ms * scale);
+    setup.close_duration_ms = static_cast<uint32_t>(setup.close_duration_ms * scale);
+    units.emplace_back(new SimCover(names[i].c_str(), gate, setup, opt.seed + i));
+    if (opt.hub) {
+      units.back()->cover.set_hub(&hub);
+      hub.register_cover(&units.back()->cover);
+    }
+    units.back()->attach(&sim);
+  }
+  if (opt.hub)
+    sim.add_component(&hub);
+  sim.setup();
+  sim.run_for(2000);
+
+  // Motor starts from the gates' own motion, sampled every physics step
+  std::vector<uint32_t> starts;
+  std::vector<bool> was_moving(units.size(), false);
+  size_t max_moving = 0;
+  auto step = [&]() {
+    sim.run_for(1);
+    size_t moving = 0;
+    for (size_t i = 0; i < units.size(); i++) {
+      const bool now_moving = units[i]->gate.is_moving();
+      if (now_moving && !was_moving[i])
+        starts.push_back(sim.now_ms());
+      was_moving[i] = now_moving;
+      moving += now_moving;
+    }
+    max_moving = std::max(max_moving, moving);
+  };
+
+  if (opt.hub) {
+    // One cover closed and turned back on its own just before the group command:
+    // the reversal restarts its motor after the stop press, inside the budget too
+    const uint32_t own_ms = sim.now_ms();
+    units[0]->cover.make_call().set_command_close().perform();
+    while (sim.now_ms() - own_ms < 2000)
+      step();
+    units[0]->cover.make_call().set_command_open().perform();
+  }
+  const uint32_t command_ms = sim.now_ms();
+  if (opt.hub) {
+    hub.move_all(0.0f);
+  } else {
+    for (auto &unit : units)
+      unit->cover.make_call().set_command_close().perform();
+  }
+
+  auto all_closed = [&]() {
+    return std::all_of(units.begin(), units.end(), [](const std::unique_ptr<SimCover> &u) {
+      return u->is_settled() && u->gate.close_endstop_active();
+    });
+  };
+  while (!all_closed() && sim.now_ms() - command_ms < 600000)
+    step();
+  const uint32_t total_ms = sim.now_ms() - command_ms;
+
+  uint32_t min_gap = 0;
+  for (size_t i = 1; i < starts.size(); i++) {
+    const uint32_t gap = starts[i] - starts[i - 1];
+    min_gap = i == 1 ? gap : std::min(min_gap, gap);
+  }
+  const uint32_t closed = std::count_if(units.begin(), units.end(), [](const std::unique_ptr<SimCover> &u) {
+    return u->gate.close_endstop_active();
+  });
+  std::printf("\n== group summary ==\n");
+  std::printf("  total_time_s            %.1f\n", total_ms / 1000.0);
+  std::printf("  closed                  %u/%u\n", closed, opt.covers);
+  std::printf("  motor_starts            %zu\n", starts.size());
+  std::printf("  min_start_gap_ms        %u\n", min_gap);
+  std::printf("  max_moving_motors       %zu\n", max_moving);
+  bool ok = check_ran("group", starts.size());
+  if (!opt.hub)
+    return ok;
+  // The hub's power budget, as the gates' motors saw it
+  if (opt.max_moving != 0 && max_moving > opt.max_moving) {
+    std::fprintf(stderr, "group: %zu motors ran at once, max_moving is %u\n", max_moving, opt.max_moving);
+    ok = false;
+  }
+  const uint32_t spacing = std::max(opt.pulse_spacing_ms, opt.inrush_ms);
+  if (starts.size() > 1 && min_gap < spacing) {
+    std::fprintf(stderr, "group: motor starts %ums apart, the budget spaces them %ums\n", min_gap, spacing);
+    ok = false;
+  }
+  return ok;
+}
+
+// The group close without the hub, then with it under a power budget (at most
+// 3 motors, 1500 ms inrush unless --max-moving / --inrush are given).
+bool scenario_group_budget(const Options &opt) {
+  Options plain = opt;
+  plain.hub = false;
+  Options budget = opt;
+  budget.hub = true;
+  if (budget.max_moving == 0)
+    budget.max_moving = 3;
+  if (budget.inrush_ms == 0)
+    budget.inrush_ms = 1500;
+  bool ok = scenario_group(plain);
+  ok &= scenario_group(budget);
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  Options opt;
+  if (!parse_args(argc, argv, opt))
+    return 2;
+  set_log_level(opt.log_level);
+  if (opt.heap_audit)
+    heap_audit_enable();
+  std::setvbuf(stdout, nullptr, _IOLBF, 0);  // keep the report interleaved with stderr logs
+
+  esphome::impulse_cover::TravelCurve open_curve, close_curve;
+  if (opt.curve) {
+    opt.cover.open_duration_ms = profile_run(opt.gate, true, &open_curve);
+    opt.cover.close_duration_ms = profile_run(opt.gate, false, &close_curve);
+    opt.cover.open_curve = &open_curve;
+    opt.cover.close_curve = &close_curve;
+    std::printf("profiled curves: open %ums, close %ums\n", opt.cover.open_duration_ms,
+                opt.cover.close_duration_ms);
+  }
+
+  bool ok = true;
+  if (opt.scenario == "partial" || opt.scenario == "all")
+    ok &= scenario_partial(opt);
+  if (opt.scenario == "pedestrian" || opt.scenario == "all")
+    ok &= scenario_pedestrian(opt);
+  if (opt.scenario == "soak" || opt.scenario == "all") {
+    uint32_t missed = 0;
+    ok &= scenario_soak(opt, &missed);
+  }
+  if (opt.scenario == "all")
+    ok &= scenario_soak_ack(opt);
+  if (opt.scenario == "drag") {
+    float landing_p95 = 0.0f;
+    uint32_t coalesced = 0;
+    ok &= scenario_drag(opt, &landing_p95, &coalesced);
+  }
+  if (opt.scenario == "all")
+    ok &= scenario_drag_settle(opt);
+  if (opt.scenario == "fleet") {
+    uint64_t loop_calls = 0;
+    ok &= scenario_fleet(opt, &loop_calls);
+  }
+  if (opt.scenario == "all")
+    ok &= scenario_fleet_hub(opt);
+  if (opt.scenario == "group")
+    ok &= scenario_group(opt);
+  if (opt.scenario == "all")
+    ok &= scenario_group_budget(opt);
+  if (opt.heap_audit) {
+    heap_audit_report();
+#ifdef IMPULSE_COVER_ZERO_HEAP
+    // The point of the mode: nothing allocates once set up
+    if (heap_audit_allocs() > 0) {
+      std::fprintf(stderr, "heap audit: %llu allocations after setup\n", (unsigned long long) heap_audit_allocs());
+      ok = false;
+    }
+#endif
+  }
+  return ok ? 0 : 1;
+}
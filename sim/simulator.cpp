@@ -0,0 +1,209 @@
+#include "simulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "esphome/core/application.h"
+#include "esphome/core/hal.h"
+#include "host_env.h"
+
+namespace impulse_sim {
+
+void SimOutput::write_state(bool state) {
+  const uint32_t now = esphome::millis();
+  if (state && !this->state_)
+    this->rising_edges_++;
+  if (state != this->state_)
+    this->last_edge_ms_ = now;
+  this->state_ = state;
+  this->gate_->set_input(this->input_, state, now);
+}
+
+void SimPin::set_level(bool level) {
+  if (level == this->level_)
+    return;
+  this->level_ = level;
+  if (this->isr_ != nullptr) {
+    ComponentScope scope;
+    this->isr_(this->isr_arg_);
+  }
+}
+
+void SimPin::attach_interrupt(void (*func)(void *), void *arg, esphome::gpio::InterruptType type) const {
+  this->isr_ = func;
+  this->isr_arg_ = arg;
+}
+
+Simulator::Simulator(const SimConfig &config) : config_(config), rng_(config.seed) {}
+
+void Simulator::add_component(esphome::Component *component) { this->components_.push_back(component); }
+
+void Simulator::add_gate(GateModel *gate, esphome::binary_sensor::BinarySensor *open_sensor,
+                         esphome::binary_sensor::BinarySensor *close_sensor, SimPin *open_pin, SimPin *close_pin) {
+  const bool open = gate->open_endstop_active();
+  const bool close = gate->close_endstop_active();
+  if (open_pin != nullptr)
+    open_pin->set_level(open);
+  if (close_pin != nullptr)
+    close_pin->set_level(close);
+  this->gates_.push_back({gate, {open_sensor, open_pin, open, open, open, 0, 0},
+                          {close_sensor, close_pin, close, close, close, 0, 0}});
+}
+
+void Simulator::add_mark(GateModel *gate, float position, float band,
+                         esphome::binary_sensor::BinarySensor *sensor) {
+  this->marks_.push_back({gate, position, band, sensor});
+}
+
+void Simulator::add_encoder(GateModel *gate, esphome::sensor::Sensor *sensor, float counts_per_travel,
+                            uint32_t interval_ms) {
+  this->encoders_.push_back({gate, sensor, counts_per_travel, interval_ms, 0});
+}
+
+void Simulator::add_current(GateModel *gate, esphome::sensor::Sensor *sensor, uint32_t interval_ms) {
+  this->currents_.push_back({gate, sensor, interval_ms, 0});
+}
+
+void Simulator::update_contact_(Contact &contact, bool level, uint32_t now_ms) {
+  if (level != contact.level) {
+    contact.level = level;
+    contact.edge_ms = now_ms;
+  }
+  bool input = contact.level;
+  const uint32_t since_edge = now_ms - contact.edge_ms;
+  if (since_edge < this->config_.bounce_ms && since_edge % 2 == 1) {
+    // Chatter every ms until the contact settles
+    input = !contact.level;
+  }
+  if (input != contact.input) {
+    contact.input = input;
+    contact.input_changed_ms = now_ms;
+    if (contact.pin != nullptr)
+      contact.pin->set_level(input);
+  }
+}
+
+uint32_t Simulator::now_ms() const { return static_cast<uint32_t>(now_us() / 1000); }
+
+void Simulator::setup() {
+  this->poll_sensors_();
+  std::stable_sort(this->components_.begin(), this->components_.end(),
+                   [](esphome::Component *a, esphome::Component *b) {
+                     return a->get_setup_priority() > b->get_setup_priority();
+                   });
+  for (auto *component : this->components_) {
+    if (auto *polling = dynamic_cast<esphome::PollingComponent *>(component)) {
+      polling->call_setup();
+    } else {
+      component->setup();
+    }
+  }
+  this->last_pass_us_ = now_us();
+  set_steady_state(true);
+}
+
+void Simulator::shutdown(bool safe_mode) {
+  set_steady_state(false);
+  if (safe_mode) {
+    for (auto *component : this->components_)
+      component->on_safe_shutdown();
+  }
+  for (auto *component : this->components_)
+    component->on_shutdown();
+}
+
+void Simulator::poll_sensors_() {
+  const uint32_t now = this->now_ms();
+  for (auto &binding : this->gates_) {
+    for (Contact *contact : {&binding.open, &binding.close}) {
+      // delayed_on_off: a level is reported once it has held for the filter delay
+      if (now - contact->input_changed_ms >= this->config_.sensor_delay_ms)
+        contact->filtered = contact->input;
+      if (contact->sensor != nullptr)
+        contact->sensor->publish_state(contact->filtered);
+    }
+  }
+  for (auto &mark : this->marks_)
+    mark.sensor->publish_state(std::fabs(mark.gate->position() - mark.position) <= mark.band);
+  for (auto &encoder : this->encoders_) {
+    if (now - encoder.last_publish_ms < encoder.interval_ms)
+      continue;
+    encoder.last_publish_ms = now;
+    encoder.sensor->publish_state(std::floor(encoder.gate->odometer() * encoder.counts_per_travel));
+  }
+  for (auto &meter : this->currents_) {
+    if (now - meter.last_publish_ms < meter.interval_ms)
+      continue;
+    meter.last_publish_ms = now;
+    meter.sensor->publish_state(meter.gate->motor_current());
+  }
+}
+
+void Simulator::advance_to_(uint64_t target_us) {
+  // Physics runs on whole milliseconds; the clock itself can sit in between.
+  uint64_t now = now_us();
+  while (now < target_us) {
+    const uint64_t next_ms_us = (now / 1000 + 1) * 1000;
+    now = std::min(next_ms_us, target_us);
+    set_now_us(now);
+    if (now % 1000 == 0) {
+      const uint32_t ms = static_cast<uint32_t>(now / 1000);
+      for (auto &binding : this->gates_) {
+        binding.gate->step(ms);
+        this->update_contact_(binding.open, binding.gate->open_endstop_active(), ms);
+        this->update_contact_(binding.close, binding.gate->close_endstop_active(), ms);
+      }
+    }
+  }
+}
+
+void Simulator::loop_pass_() {
+  this->last_pass_us_ = now_us();
+  this->loop_passes_++;
+  esphome::App.set_loop_component_start_time(esphome::millis());
+  this->poll_sensors_();
+  scheduler_run_due();
+  for (auto *component : this->components_) {
+    if (!component->is_failed() && component->is_loop_enabled()) {
+      ComponentScope scope;
+      component->loop();
+      this->component_loops_++;
+    }
+  }
+  if (this->config_.loop_jitter_ms > 0) {
+    // Time burnt by the other components sharing the loop.
+    std::uniform_int_distribution<uint32_t> busy(0, this->config_.loop_jitter_ms * 1000);
+    this->advance_to_(now_us() + busy(this->rng_));
+  }
+}
+
+void Simulator::run_for(uint32_t ms) {
+  const uint64_t until = now_us() + uint64_t(ms) * 1000;
+  while (true) {
+    // The real loop sleeps until the loop interval elapses or the next
+    // scheduler item is due, whichever comes first.
+    uint64_t wake = this->last_pass_us_ + uint64_t(this->config_.loop_interval_ms) * 1000;
+    uint64_t due;
+    if (scheduler_next_due_us(&due))
+      wake = std::min(wake, due);
+    wake = std::max(wake, now_us());
+    if (wake > until) {
+      this->advance_to_(until);
+      return;
+    }
+    this->advance_to_(wake);
+    this->loop_pass_();
+  }
+}
+
+bool Simulator::run_until(const std::function<bool()> &done, uint32_t timeout_ms) {
+  const uint32_t deadline = this->now_ms() + timeout_ms;
+  while (this->now_ms() < deadline) {
+    this->run_for(1);
+    if (done())
+      return true;
+  }
+  return done();
+}
+
+}  // namespace impulse_sim
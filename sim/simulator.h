@@ -0,0 +1,147 @@
+#pragma once
+
+// Drives the host build: a fake main loop (scheduler pass + component loops)
+// at a configurable interval and jitter, with gate physics integrated at 1 ms.
+
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "esphome/components/binary_sensor/binary_sensor.h"
+#include "esphome/components/output/binary_output.h"
+#include "esphome/components/sensor/sensor.h"
+#include "esphome/core/component.h"
+#include "esphome/core/gpio.h"
+#include "gate_model.h"
+
+namespace impulse_sim {
+
+// Relay output wired to a gate controller's impulse input.
+class SimOutput : public esphome::output::BinaryOutput {
+ public:
+  explicit SimOutput(GateModel *gate, GateInput input = GateInput::IMPULSE) : gate_(gate), input_(input) {}
+
+  bool get_state() const { return this->state_; }
+  uint32_t get_rising_edges() const { return this->rising_edges_; }
+  uint32_t get_last_edge_ms() const { return this->last_edge_ms_; }
+
+ protected:
+  void write_state(bool state) override;
+
+  GateModel *gate_;
+  GateInput input_;
+  bool state_{false};
+  uint32_t rising_edges_{0};
+  uint32_t last_edge_ms_{0};
+};
+
+// Endstop contact read directly; a level change runs the attached interrupt
+// handler at the physics step where it happens, ahead of any loop pass.
+class SimPin : public esphome::InternalGPIOPin {
+ public:
+  bool digital_read() override { return this->level_; }
+  std::string dump_summary() const override { return "sim endstop"; }
+  void set_level(bool level);
+
+ protected:
+  void attach_interrupt(void (*func)(void *), void *arg, esphome::gpio::InterruptType type) const override;
+
+  bool level_{false};
+  mutable void (*isr_)(void *){nullptr};
+  mutable void *isr_arg_{nullptr};
+};
+
+struct SimConfig {
+  uint32_t loop_interval_ms{16};  // App loop interval (ESPHome default)
+  uint32_t loop_jitter_ms{0};     // extra time other components spend per loop pass
+  uint32_t sensor_delay_ms{0};    // binary sensor delayed_on_off filter on the endstops
+  uint32_t bounce_ms{0};          // endstop contact bounce after each change
+  uint32_t seed{1};
+};
+
+class Simulator {
+ public:
+  explicit Simulator(const SimConfig &config);
+
+  void add_component(esphome::Component *component);
+  // Endstop sensors are polled once per loop pass, like GPIO binary sensors,
+  // through the configured filter delay; the pins follow the contacts every ms.
+  void add_gate(GateModel *gate, esphome::binary_sensor::BinarySensor *open_sensor,
+                esphome::binary_sensor::BinarySensor *close_sensor, SimPin *open_pin = nullptr,
+                SimPin *close_pin = nullptr);
+
+  // Reed switch reading true within band of position, polled like the endstops
+  void add_mark(GateModel *gate, float position, float band, esphome::binary_sensor::BinarySensor *sensor);
+  // Pulse counter total, published every interval_ms like a pulse_counter sensor
+  void add_encoder(GateModel *gate, esphome::sensor::Sensor *sensor, float counts_per_travel, uint32_t interval_ms);
+  // Motor current, published every interval_ms
+  void add_current(GateModel *gate, esphome::sensor::Sensor *sensor, uint32_t interval_ms);
+
+  void setup();
+  // Runs the components' shutdown hooks, as App does before a reboot.
+  void shutdown(bool safe_mode = false);
+  void run_for(uint32_t ms);
+  // Runs until done() holds at the end of a loop pass; false on timeout.
+  bool run_until(const std::function<bool()> &done, uint32_t timeout_ms);
+
+  uint32_t now_ms() const;
+  uint64_t get_loop_passes() const { return this->loop_passes_; }
+  uint64_t get_component_loops() const { return this->component_loops_; }
+  SimConfig &config() { return this->config_; }
+
+ protected:
+  // One endstop contact: the input level with bounce, and what the filtered sensor reports
+  struct Contact {
+    esphome::binary_sensor::BinarySensor *sensor;
+    SimPin *pin;
+    bool level;        // contact state from the gate position
+    bool input;        // level at the GPIO, bounce included
+    bool filtered;
+    uint32_t edge_ms;  // last contact change
+    uint32_t input_changed_ms;
+  };
+  struct GateBinding {
+    GateModel *gate;
+    Contact open;
+    Contact close;
+  };
+
+  struct Mark {
+    GateModel *gate;
+    float position;
+    float band;
+    esphome::binary_sensor::BinarySensor *sensor;
+  };
+  struct Encoder {
+    GateModel *gate;
+    esphome::sensor::Sensor *sensor;
+    float counts_per_travel;
+    uint32_t interval_ms;
+    uint32_t last_publish_ms;
+  };
+  struct CurrentMeter {
+    GateModel *gate;
+    esphome::sensor::Sensor *sensor;
+    uint32_t interval_ms;
+    uint32_t last_publish_ms;
+  };
+
+  void update_contact_(Contact &contact, bool level, uint32_t now_ms);
+  void advance_to_(uint64_t target_us);
+  void loop_pass_();
+  void poll_sensors_();
+
+  SimConfig config_;
+  std::mt19937 rng_;
+  std::vector<esphome::Component *> components_;
+  std::vector<GateBinding> gates_;
+  std::vector<Mark> marks_;
+  std::vector<Encoder> encoders_;
+  std::vector<CurrentMeter> currents_;
+  uint64_t last_pass_us_{0};
+  uint64_t loop_passes_{0};
+  uint64_t component_loops_{0};
+};
+
+}  // namespace impulse_sim
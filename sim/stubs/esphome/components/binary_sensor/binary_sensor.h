@@ -0,0 +1,33 @@
+#pragma once
+
+#include <functional>
+
+#include "esphome/core/component.h"
+#include "esphome/core/entity_base.h"
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+namespace binary_sensor {
+
+// Host stand-in without filters: publish_state() dedups and runs the callbacks
+// immediately, like a filter-less GPIO binary sensor.
+class BinarySensor : public EntityBase {
+ public:
+  explicit BinarySensor() = default;
+
+  void add_on_state_callback(std::function<void(bool)> &&callback) {
+    this->state_callback_.add(std::move(callback));
+  }
+  void publish_state(bool state);
+  void publish_initial_state(bool state);
+  bool has_state() const { return this->has_state_; }
+
+  bool state{false};
+
+ protected:
+  CallbackManager<void(bool)> state_callback_{};
+  bool has_state_{false};
+};
+
+}  // namespace binary_sensor
+}  // namespace esphome
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "esphome/core/component.h"
+#include "esphome/core/entity_base.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/optional.h"
+#include "esphome/core/preferences.h"
+
+namespace esphome {
+namespace cover {
+
+extern const float COVER_OPEN;
+extern const float COVER_CLOSED;
+
+enum CoverOperation : uint8_t {
+  COVER_OPERATION_IDLE = 0,
+  COVER_OPERATION_OPENING,
+  COVER_OPERATION_CLOSING,
+};
+
+const char *cover_operation_to_str(CoverOperation op);
+
+class Cover;
+
+class CoverTraits {
+ public:
+  bool get_is_assumed_state() const { return this->is_assumed_state_; }
+  void set_is_assumed_state(bool v) { this->is_assumed_state_ = v; }
+  bool get_supports_position() const { return this->supports_position_; }
+  void set_supports_position(bool v) { this->supports_position_ = v; }
+  bool get_supports_tilt() const { return this->supports_tilt_; }
+  void set_supports_tilt(bool v) { this->supports_tilt_ = v; }
+  bool get_supports_toggle() const { return this->supports_toggle_; }
+  void set_supports_toggle(bool v) { this->supports_toggle_ = v; }
+  bool get_supports_stop() const { return this->supports_stop_; }
+  void set_supports_stop(bool v) { this->supports_stop_ = v; }
+
+ protected:
+  bool is_assumed_state_{false};
+  bool supports_position_{false};
+  bool supports_tilt_{false};
+  bool supports_toggle_{false};
+  bool supports_stop_{false};
+};
+
+class CoverCall {
+ public:
+  explicit CoverCall(Cover *parent) : parent_(parent) {}
+
+  CoverCall &set_command_open();
+  CoverCall &set_command_close();
+  CoverCall &set_command_stop();
+  CoverCall &set_command_toggle();
+  CoverCall &set_position(float position);
+  CoverCall &set_stop(bool stop);
+
+  void perform();
+
+  const optional<float> &get_position() const { return this->position_; }
+  const optional<float> &get_tilt() const { return this->tilt_; }
+  bool get_stop() const { return this->stop_; }
+  const optional<bool> &get_toggle() const { return this->toggle_; }
+
+ protected:
+  Cover *parent_;
+  bool stop_{false};
+  optional<float> position_{};
+  optional<float> tilt_{};
+  optional<bool> toggle_{};
+};
+
+struct CoverRestoreState {
+  float position;
+  float tilt;
+
+  CoverCall to_call(Cover *cover);
+  void apply(Cover *cover);
+} __attribute__((packed));
+
+class Cover : public EntityBase {
+ public:
+  Cover() = default;
+
+  CoverOperation current_operation{COVER_OPERATION_IDLE};
+  float position;
+  float tilt{COVER_OPEN};
+
+  CoverCall make_call() { return CoverCall(this); }
+  void add_on_state_callback(std::function<void()> &&f) { this->state_callback_.add(std::move(f)); }
+  void publish_state(bool save = true);
+
+  virtual CoverTraits get_traits() = 0;
+
+  bool is_fully_open() const { return this->position == COVER_OPEN; }
+  bool is_fully_closed() const { return this->position == COVER_CLOSED; }
+
+ protected:
+  friend CoverCall;
+
+  virtual void control(const CoverCall &call) = 0;
+
+  optional<CoverRestoreState> restore_state_();
+
+  CallbackManager<void()> state_callback_{};
+  ESPPreferenceObject rtc_;
+};
+
+}  // namespace cover
+}  // namespace esphome
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+namespace output {
+
+class BinaryOutput {
+ public:
+  virtual ~BinaryOutput() = default;
+
+  void set_inverted(bool inverted) { this->inverted_ = inverted; }
+  bool is_inverted() const { return this->inverted_; }
+
+  virtual void turn_on() { this->write_state(!this->inverted_); }
+  virtual void turn_off() { this->write_state(this->inverted_); }
+
+ protected:
+  virtual void write_state(bool state) = 0;
+
+  bool inverted_{false};
+};
+
+}  // namespace output
+}  // namespace esphome
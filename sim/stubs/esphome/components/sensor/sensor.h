@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cmath>
+#include <functional>
+
+#include "esphome/core/component.h"
+#include "esphome/core/entity_base.h"
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+namespace sensor {
+
+// Host stand-in without filters: publish_state() stores the value and runs the
+// callbacks immediately.
+class Sensor : public EntityBase {
+ public:
+  explicit Sensor() = default;
+
+  void add_on_state_callback(std::function<void(float)> &&callback) {
+    this->callback_.add(std::move(callback));
+  }
+  void publish_state(float state) {
+    this->state = state;
+    this->has_state_ = true;
+    this->publishes_++;
+    this->callback_.call(state);
+  }
+  bool has_state() const { return this->has_state_; }
+  // Host only: number of publish_state() calls, for publish-rate reports
+  uint32_t get_publish_count() const { return this->publishes_; }
+
+  float state{NAN};
+
+ protected:
+  CallbackManager<void(float)> callback_{};
+  bool has_state_{false};
+  uint32_t publishes_{0};
+};
+
+}  // namespace sensor
+}  // namespace esphome
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "esphome/core/component.h"
+#include "esphome/core/entity_base.h"
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+namespace text_sensor {
+
+// Host stand-in without filters: publish_state() stores the value and runs the
+// callbacks immediately.
+class TextSensor : public EntityBase {
+ public:
+  explicit TextSensor() = default;
+
+  void add_on_state_callback(std::function<void(std::string)> &&callback) {
+    this->callback_.add(std::move(callback));
+  }
+  void publish_state(const std::string &state) {
+    this->state = state;
+    this->has_state_ = true;
+    this->publishes_++;
+    this->callback_.call(state);
+  }
+  bool has_state() const { return this->has_state_; }
+  // Host only: number of publish_state() calls, for publish-rate reports
+  uint32_t get_publish_count() const { return this->publishes_; }
+
+  std::string state;
+
+ protected:
+  CallbackManager<void(std::string)> callback_{};
+  bool has_state_{false};
+  uint32_t publishes_{0};
+};
+
+}  // namespace text_sensor
+}  // namespace esphome
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "esphome/core/component.h"
+#include "esphome/core/hal.h"
+
+namespace esphome {
+
+class Application {
+ public:
+  const std::string &get_name() const { return this->name_; }
+  uint32_t get_loop_component_start_time() const { return this->loop_component_start_time_; }
+  void set_loop_component_start_time(uint32_t now) { this->loop_component_start_time_ = now; }
+
+ protected:
+  std::string name_{"impulse-cover-sim"};
+  uint32_t loop_component_start_time_{0};
+};
+
+extern Application App;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+}  // namespace esphome
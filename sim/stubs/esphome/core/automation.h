@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+
+// Host stand-in: instead of running an Automation, a trigger counts its
+// firings and calls an optional hook installed by the simulation.
+template<typename... Ts> class Trigger {
+ public:
+  virtual ~Trigger() = default;
+
+  void trigger(Ts... x) {
+    this->fire_count_++;
+    if (this->hook_)
+      this->hook_(x...);
+  }
+  void set_hook(std::function<void(Ts...)> &&hook) { this->hook_ = std::move(hook); }
+  uint32_t get_fire_count() const { return this->fire_count_; }
+
+ protected:
+  std::function<void(Ts...)> hook_;
+  uint32_t fire_count_{0};
+};
+
+// Constant or lambda argument of an action, as generated for templatable options
+template<typename T, typename... X> class TemplatableValue {
+ public:
+  TemplatableValue() = default;
+  TemplatableValue(T value) : value_(value) {}
+  TemplatableValue(std::function<T(X...)> f) : f_(std::move(f)) {}
+
+  T value(X... x) { return this->f_ ? this->f_(x...) : this->value_; }
+
+ protected:
+  T value_{};
+  std::function<T(X...)> f_;
+};
+
+#define TEMPLATABLE_VALUE_(type, name) \
+ protected: \
+  TemplatableValue<type, Ts...> name##_{}; \
+\
+ public: \
+  template<typename V> void set_##name(V name) { this->name##_ = name; }
+
+#define TEMPLATABLE_VALUE(type, name) TEMPLATABLE_VALUE_(type, name)
+
+template<typename... Ts> class Action {
+ public:
+  virtual ~Action() = default;
+  virtual void play(Ts... x) = 0;
+};
+
+}  // namespace esphome
@@ -0,0 +1,4 @@
+#pragma once
+
+// Host build: feature defines normally generated by ESPHome codegen are passed
+// on the compiler command line (see sim/CMakeLists.txt).
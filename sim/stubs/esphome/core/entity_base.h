@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace esphome {
+
+enum EntityCategory : uint8_t {
+  ENTITY_CATEGORY_NONE = 0,
+  ENTITY_CATEGORY_CONFIG = 1,
+  ENTITY_CATEGORY_DIAGNOSTIC = 2,
+};
+
+class EntityBase {
+ public:
+  const std::string &get_name() const { return this->name_; }
+  void set_name(const char *name);
+  uint32_t get_object_id_hash() const { return this->object_id_hash_; }
+  EntityCategory get_entity_category() const { return this->entity_category_; }
+  void set_entity_category(EntityCategory category) { this->entity_category_ = category; }
+
+ protected:
+  std::string name_;
+  uint32_t object_id_hash_{0};
+  EntityCategory entity_category_{ENTITY_CATEGORY_NONE};
+};
+
+}  // namespace esphome
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace esphome {
+
+#define LOG_PIN(prefix, pin) \
+  if ((pin) != nullptr) { \
+    ESP_LOGCONFIG(TAG, prefix "%s", (pin)->dump_summary().c_str()); \
+  }
+
+namespace gpio {
+enum InterruptType : uint8_t {
+  INTERRUPT_RISING_EDGE = 1,
+  INTERRUPT_FALLING_EDGE = 2,
+  INTERRUPT_ANY_EDGE = 3,
+};
+}  // namespace gpio
+
+class InternalGPIOPin;
+
+// Host stand-in: forwards to the pin it was made from.
+class ISRInternalGPIOPin {
+ public:
+  ISRInternalGPIOPin() = default;
+  explicit ISRInternalGPIOPin(InternalGPIOPin *pin) : pin_(pin) {}
+  bool digital_read();
+
+ protected:
+  InternalGPIOPin *pin_{nullptr};
+};
+
+class InternalGPIOPin {
+ public:
+  virtual ~InternalGPIOPin() = default;
+  virtual void setup() {}
+  virtual bool digital_read() = 0;
+  virtual std::string dump_summary() const = 0;
+  virtual ISRInternalGPIOPin to_isr() const { return ISRInternalGPIOPin(const_cast<InternalGPIOPin *>(this)); }
+
+  template<typename T> void attach_interrupt(void (*func)(T *), T *arg, gpio::InterruptType type) const {
+    this->attach_interrupt(reinterpret_cast<void (*)(void *)>(func), arg, type);
+  }
+
+ protected:
+  virtual void attach_interrupt(void (*func)(void *), void *arg, gpio::InterruptType type) const = 0;
+};
+
+inline bool ISRInternalGPIOPin::digital_read() { return this->pin_->digital_read(); }
+
+}  // namespace esphome
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+#define IRAM_ATTR
+
+namespace esphome {
+
+// Backed by the simulated clock in sim/host_env.cpp.
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+
+}  // namespace esphome